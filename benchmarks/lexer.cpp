@@ -0,0 +1,66 @@
+// Lexes the same program with the Flex scanner and with the hand-written Lexer and prints the
+// throughput of each. Built with -DHEBE_ENABLE_BENCHMARKS=ON and HEBE_LEXER=flex.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "lexer/lexer.h"
+#include "logging.h"
+
+typedef struct yy_buffer_state* YY_BUFFER_STATE;
+extern YY_BUFFER_STATE yy_scan_string(const char* str);
+extern void yy_delete_buffer(YY_BUFFER_STATE buffer);
+extern void yy_switch_to_buffer(YY_BUFFER_STATE new_buffer);
+extern int yylex();
+
+namespace {
+std::string makeProgram(int procedures) {
+  std::string text;
+  for (int i = 0; i < procedures; i++) {
+    text += "create step_" + std::to_string(i % 100) + "\n";
+    text += "    save counter + 1.25 * sqrt(value_x, 3) - 7 / 2.5f in counter\n";
+    text += "done\n";
+    text += "show counter -> 42\n";
+  }
+  return text;
+}
+
+template <typename Scan> void measure(const char* name, const std::string& text, Scan scan) {
+  auto start = std::chrono::steady_clock::now();
+  size_t tokens = scan();
+  double seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  std::printf("%-12s %10zu tokens %8.3f s %8.1f MB/s\n", name, tokens, seconds,
+              text.size() / 1e6 / seconds);
+}
+} // namespace
+
+int main(int argc, char** argv) {
+  // The lexers report invalid tokens.
+  logsys::init();
+
+  int procedures = argc > 1 ? std::atoi(argv[1]) : 1000000;
+  std::string text = makeProgram(procedures);
+  std::printf("%.1f MB of input\n", text.size() / 1e6);
+
+  measure("flex", text, [&] {
+    YY_BUFFER_STATE buffer = yy_scan_string(text.c_str());
+    yy_switch_to_buffer(buffer);
+    size_t tokens = 0;
+    while (yylex() != 0)
+      tokens++;
+    yy_delete_buffer(buffer);
+    return tokens;
+  });
+
+  measure("handwritten", text, [&] {
+    Lexer lexer(text);
+    size_t tokens = 0;
+    while (lexer.next().kind != TokenKind::End)
+      tokens++;
+    return tokens;
+  });
+  return 0;
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <utility>
 #include <vector>
@@ -9,20 +10,47 @@
 enum class NodeType {
   Program,
   Number,
+  Integer,
+  Variable,
   BinaryOp,
+  BuiltinCall,
   Assignment,
+  Show,
   Procedure,
   ProcedureBody,
-  ProcedureCall
+  ProcedureCall,
+  Parallel
 };
 
+/**
+ * @brief Types of the values a hebe expression can produce.
+ * Ordered from narrowest to widest so that mixed expressions convert to the widest type.
+ *
+ */
+enum class ValueType { Unknown, I64, F32, F64 };
+
 std::string getNodeType(NodeType type);
+std::string getValueType(ValueType type);
+ValueType joinValueTypes(ValueType a, ValueType b);
 
 class ASTNode {
 public:
   NodeType type;
+  // Type of the value produced by the node. Set by literals and by the TypeChecker.
+  ValueType valueType = ValueType::Unknown;
+  // Number of parents pointing to the node. Expressions shared by an ExpressionTable have more
+  // than one and are deleted together with the last of them.
+  uint32_t references = 1;
   explicit ASTNode(NodeType t) : type(t) {}
   virtual ~ASTNode() = default;
+
+  // Moves the children of the node to the given list. The node is left without children.
+  virtual void takeChildren(std::vector<ASTNode*>& /*children*/) {}
+
+protected:
+  // Deletes all the descendants of the node with an explicit work list instead of one destructor
+  // call per tree level, so that very deep trees do not overflow the stack.
+  void deleteChildren();
 };
 
 /**
@@ -32,31 +60,65 @@ public:
  */
 class ProgramNode : public ASTNode {
   std::vector<ASTNode*> items;
+  // Source line where each item starts, 0 if unknown. Kept out of the items because an expression
+  // item can be shared with other lines.
+  std::vector<int> lines;
 
 public:
   ProgramNode() : ASTNode(NodeType::Program) {}
 
-  ~ProgramNode() override {
-    for (ASTNode* n : items)
-      delete n;
+  ~ProgramNode() override { this->deleteChildren(); }
+
+  void takeChildren(std::vector<ASTNode*>& children) override {
+    children.insert(children.end(), items.begin(), items.end());
+    items.clear();
+    lines.clear();
   }
 
-  void append(ASTNode* n) {
-    if (n)
+  void append(ASTNode* n, int line = 0) {
+    if (n) {
       items.push_back(n);
+      lines.push_back(line);
+    }
   }
   std::vector<ASTNode*> getItems() { return items; }
+  int getLine(size_t index) const { return lines[index]; }
 };
 
 /**
- * @brief Number node.
- * E.g. 42.0
+ * @brief Floating point number node.
+ * E.g. 42.0 (f64) | 42.0f (f32)
  *
  */
 class NumberNode : public ASTNode {
 public:
   double value;
-  NumberNode(double val) : ASTNode(NodeType::Number), value(val) {}
+  NumberNode(double val, ValueType literalType = ValueType::F64)
+      : ASTNode(NodeType::Number), value(val) {
+    valueType = literalType;
+  }
+};
+
+/**
+ * @brief Integer number node.
+ * E.g. 42
+ *
+ */
+class IntegerNode : public ASTNode {
+public:
+  int64_t value;
+  IntegerNode(int64_t val) : ASTNode(NodeType::Integer), value(val) { valueType = ValueType::I64; }
+};
+
+/**
+ * @brief Reads the value of a global variable.
+ * E.g. x
+ *
+ */
+class VariableNode : public ASTNode {
+public:
+  std::string name;
+  VariableNode(std::string name) : ASTNode(NodeType::Variable), name(std::move(name)) {}
 };
 
 /**
@@ -74,9 +136,50 @@ public:
     type = NodeType::BinaryOp;
   }
 
-  ~BinaryOpNode() override {
-    delete left;
-    delete right;
+  ~BinaryOpNode() override { this->deleteChildren(); }
+
+  void takeChildren(std::vector<ASTNode*>& children) override {
+    children.push_back(left);
+    children.push_back(right);
+    left = right = nullptr;
+  }
+};
+
+/**
+ * @brief Call to a built-in math function.
+ * E.g. sqrt(x) | fma(a, b, c)
+ *
+ */
+class BuiltinCallNode : public ASTNode {
+public:
+  std::string name;
+  std::vector<ASTNode*> arguments;
+  BuiltinCallNode(std::string name, std::vector<ASTNode*> arguments)
+      : ASTNode(NodeType::BuiltinCall), name(std::move(name)), arguments(std::move(arguments)) {}
+
+  ~BuiltinCallNode() override { this->deleteChildren(); }
+
+  void takeChildren(std::vector<ASTNode*>& children) override {
+    children.insert(children.end(), arguments.begin(), arguments.end());
+    arguments.clear();
+  }
+};
+
+/**
+ * @brief Prints the values of one or more expressions in a line.
+ * E.g. show x -> y * 2
+ *
+ */
+class ShowNode : public ASTNode {
+public:
+  std::vector<ASTNode*> values;
+  ShowNode(std::vector<ASTNode*> values) : ASTNode(NodeType::Show), values(std::move(values)) {}
+
+  ~ShowNode() override { this->deleteChildren(); }
+
+  void takeChildren(std::vector<ASTNode*>& children) override {
+    children.insert(children.end(), values.begin(), values.end());
+    values.clear();
   }
 };
 
@@ -92,7 +195,12 @@ public:
   AssignmentNode(std::string name, ASTNode* value)
       : ASTNode(NodeType::Assignment), name(std::move(name)), value(value) {}
 
-  ~AssignmentNode() override { delete value; }
+  ~AssignmentNode() override { this->deleteChildren(); }
+
+  void takeChildren(std::vector<ASTNode*>& children) override {
+    children.push_back(value);
+    value = nullptr;
+  }
 };
 
 /**
@@ -102,21 +210,29 @@ public:
  */
 class ProcedureBodyNode : public ASTNode {
   std::vector<ASTNode*> items;
+  // Source line where each item starts, as in ProgramNode.
+  std::vector<int> lines;
 
 public:
   ProcedureBodyNode() : ASTNode(NodeType::ProcedureBody) {}
 
-  ~ProcedureBodyNode() override {
-    for (ASTNode* n : items)
-      delete n;
+  ~ProcedureBodyNode() override { this->deleteChildren(); }
+
+  void takeChildren(std::vector<ASTNode*>& children) override {
+    children.insert(children.end(), items.begin(), items.end());
+    items.clear();
+    lines.clear();
   }
 
-  void append(ASTNode* n) {
-    if (n)
+  void append(ASTNode* n, int line = 0) {
+    if (n) {
       items.push_back(n);
+      lines.push_back(line);
+    }
   }
 
   std::vector<ASTNode*> getItems() { return items; }
+  int getLine(size_t index) const { return lines[index]; }
 };
 
 /**
@@ -128,11 +244,21 @@ class ProcedureNode : public ASTNode {
 public:
   std::string name;
   ASTNode* body;
+  // Source line of the create statement, 0 if unknown.
+  int line;
+  // Source file of the create statement. Empty for the input file, only set for the procedures of
+  // the files merged into a library.
+  std::string file;
+
+  ProcedureNode(std::string name, ASTNode* body, int line = 0)
+      : ASTNode(NodeType::Procedure), name(std::move(name)), body(body), line(line) {}
 
-  ProcedureNode(std::string name, ASTNode* body)
-      : ASTNode(NodeType::Procedure), name(std::move(name)), body(body) {}
+  ~ProcedureNode() override { this->deleteChildren(); }
 
-  ~ProcedureNode() override { delete body; }
+  void takeChildren(std::vector<ASTNode*>& children) override {
+    children.push_back(body);
+    body = nullptr;
+  }
 };
 
 /**
@@ -146,3 +272,22 @@ public:
 
   ProcedureCallNode(std::string name) : ASTNode(NodeType::ProcedureCall), name(std::move(name)) {}
 };
+
+/**
+ * @brief Block of procedure calls that run concurrently and are joined at the end of the block.
+ * E.g. PARALLEL PROCEDUREBODY DONE.
+ *
+ */
+class ParallelNode : public ASTNode {
+public:
+  ASTNode* body;
+
+  ParallelNode(ASTNode* body) : ASTNode(NodeType::Parallel), body(body) {}
+
+  ~ParallelNode() override { this->deleteChildren(); }
+
+  void takeChildren(std::vector<ASTNode*>& children) override {
+    children.push_back(body);
+    body = nullptr;
+  }
+};
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+
+#include "ast/ast.h"
+
+/**
+ * @brief Hash-consing table for the pure expression nodes (literals, variable reads, binary
+ * operations and built-in calls).
+ * Structurally equal expressions built through the table become the same node, referenced once
+ * per parent, so a repeated subexpression is stored once and the compiler generates it once.
+ *
+ */
+class ExpressionTable {
+public:
+  // Returns the node equal to a new expression node whose operands were returned by the table.
+  // The given node is deleted if an equal one exists, which gains a reference instead.
+  ASTNode* intern(ASTNode* node);
+  // Drops one reference to an interned node. The nodes left without references are deleted.
+  void release(ASTNode* node);
+  // Forgets every node without deleting them, they belong to the AST built with the table. Must be
+  // called before that AST is deleted if the table is used again.
+  void clear() { this->nodes.clear(); }
+
+  size_t size() const { return this->nodes.size(); }
+
+private:
+  // Table containing structural key <std::string> and node <ASTNode*> of every interned node.
+  std::unordered_map<std::string, ASTNode*> nodes;
+
+  // Key identifying the node by its kind, its own fields and the address of its operands.
+  static std::string getKey(ASTNode* node);
+};
@@ -2,16 +2,37 @@
 
 #include <llvm/IR/BasicBlock.h>
 #include <llvm/IR/Constant.h>
+#include <llvm/IR/DIBuilder.h>
 #include <llvm/IR/Function.h>
 #include <llvm/IR/IRBuilder.h>
 #include <llvm/IR/LLVMContext.h>
 #include <llvm/IR/Module.h>
 #include <llvm/IR/NoFolder.h>
+#include <llvm/Support/Error.h>
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "ast/ast.h"
+#include "options.h"
+#include "semantic/parallel_checker.h"
+#include "semantic/type_checker.h"
+
+namespace llvm::orc {
+class LLJIT;
+} // namespace llvm::orc
+
+class StateFile;
+
+// Prefix of the global counting the entries of each procedure.
+inline const std::string profileCounterPrefix = "hebe.prof.";
+// Prefix of the global holding the code address called for each procedure in tiered mode.
+inline const std::string procedureStubPrefix = "hebe.stub.";
+// Module flag recording the fast-math flags the code was generated with.
+inline const std::string fastMathModuleFlag = "hebe.fast-math";
 
 class Compiler {
 public:
@@ -25,15 +46,37 @@ public:
     this->rootNode = rootNode;
   };
 
+  Compiler(ASTNode* rootNode, CompilerOptions options) : options(std::move(options)) {
+    this->initializeLLVM();
+    this->rootNode = rootNode;
+  };
+
   ~Compiler() = default;
 
   // =================================================================================================
 
+  // Logs the tree at the debug level.
   void printNodeTree(ASTNode* node = nullptr, int depth = 0);
   void printLLVMIR();
   void exportIRToFile(const std::string& fileName = "output.ll");
 
   void generateCode();
+  void optimize();
+
+  // Generates the procedures of a library instead of a program. The AST may only contain
+  // procedure definitions.
+  void generateLibrary();
+  // Writes the bitcode of a generated library to path and its symbol index next to it.
+  void writeLibrary(const std::string& path);
+
+  // Deletes the AST given to the constructor. Code generation does not need it anymore.
+  void releaseAST();
+
+  // Streaming code generation. Items are generated and freed as soon as the parser reduces them
+  // instead of building the whole ProgramNode first.
+  void beginStreaming();
+  void streamItem(ASTNode* node, int line);
+  void finishStreaming();
 
   int runJIT();
 
@@ -44,6 +87,33 @@ public:
   friend class Compiler_codegen_number_node_Test;
   friend class Compiler_codegen_binary_op_node_Test;
   friend class Compiler_codegen_assignment_node_Test;
+  friend class Compiler_codegen_f32_number_node_Test;
+  friend class Compiler_codegen_integer_node_Test;
+  friend class Compiler_codegen_integer_binary_op_node_Test;
+  friend class Compiler_codegen_mixed_binary_op_node_converts_to_widest_type_Test;
+  friend class Compiler_codegen_typed_program_Test;
+  friend class Compiler_codegen_builtin_call_node_Test;
+  friend class Compiler_codegen_show_node_Test;
+  friend class Compiler_profile_counters_are_emitted_Test;
+  friend class Compiler_profile_no_counters_without_instrumentation_Test;
+  friend class Compiler_tiered_calls_go_through_stubs_Test;
+  friend class Compiler_deep_ast_long_left_associative_expression_Test;
+  friend class Compiler_deep_ast_deep_right_nested_expression_Test;
+  friend class Compiler_deep_ast_deep_shared_expression_Test;
+  friend class Compiler_fast_math_flags_are_set_on_operations_Test;
+  friend class Compiler_fast_math_strict_by_default_Test;
+  friend class Compiler_parallel_block_spawns_and_joins_Test;
+  friend class Compiler_low_memory_release_ast_after_code_generation_Test;
+  friend class Compiler_debug_info_statements_have_source_lines_Test;
+  friend class Compiler_debug_info_library_procedures_keep_their_file_Test;
+  friend class Compiler_debug_info_disabled_by_default_Test;
+  friend class Compiler_common_subexpressions_shared_expressions_are_generated_once_Test;
+  friend class Compiler_common_subexpressions_assignments_and_calls_invalidate_values_Test;
+  friend class Compiler_state_globals_are_declared_with_state_file_Test;
+  friend class Compiler_libraries_only_called_procedures_are_linked_Test;
+  friend class Compiler_libraries_unused_library_is_not_read_Test;
+  friend class Streaming_inline_streaming_generates_code_Test;
+  friend class Streaming_threaded_streaming_generates_code_Test;
 
 private:
   std::unique_ptr<llvm::LLVMContext> context;
@@ -56,9 +126,39 @@ private:
 
   std::unique_ptr<llvm::Module> module;
 
+  // Debug info of the module. Only exists with debug info enabled and until the run function is
+  // finished.
+  std::unique_ptr<llvm::DIBuilder> debugBuilder;
+  // File of the compile unit, the input file.
+  llvm::DIFile* debugFile = nullptr;
+  // Table containing source path <std::string> and debug file <llvm::DIFile*> of every file with
+  // procedures in the module.
+  std::unordered_map<std::string, llvm::DIFile*> debugFiles;
+
   // Node where Bison will save a ProgramNode with all the parsed AST.
   ASTNode* rootNode = nullptr;
 
+  CompilerOptions options;
+
+  // Types of the expressions and global variables.
+  TypeChecker typeChecker;
+  // Globals accessed by each procedure, to reject races in parallel blocks.
+  ParallelChecker parallelChecker;
+
+  // Slot where "run" stores the value of its expression lines.
+  llvm::AllocaInst* runDebugAlloca = nullptr;
+  // Value of the last top level item generated in "run".
+  llvm::Value* lastRunExpr = nullptr;
+
+  // Values of the shared expressions already generated in the current function. The ones reading
+  // a global are dropped when it is assigned and all of them when a procedure is called.
+  std::unordered_map<ASTNode*, llvm::Value*> valueCache;
+  // Table containing global name <std::string> and cached expressions <ASTNode*> reading it.
+  std::unordered_map<std::string, std::vector<ASTNode*>> valueCacheReaders;
+  // Table containing cached expression <ASTNode*> and cached expressions <ASTNode*> using it as an
+  // operand, which are dropped with it.
+  std::unordered_map<ASTNode*, std::vector<ASTNode*>> valueCacheDependents;
+
   // ===============================================================================================
   // Lookup tables
 
@@ -70,18 +170,68 @@ private:
   // Table containing name <std::string> and pointer <llvm::GlobalVariable*> to all created global
   // variables.
   std::unordered_map<std::string, llvm::GlobalVariable*> globalVariableTable;
+  // Names of the functions that increment a profile counter on entry.
+  std::vector<std::string> profiledFunctions;
+  // Table containing procedure name <std::string> and library path <std::string> of every
+  // procedure of the imported libraries.
+  std::unordered_map<std::string, std::string> importedProcedures;
+  // Table containing name <std::string> and type <ValueType> of the globals used by the imported
+  // libraries.
+  std::unordered_map<std::string, ValueType> importedGlobals;
+  // Paths of the libraries with at least one procedure called by the program.
+  std::unordered_set<std::string> usedLibraries;
 
   // ================================================================================================
 
   void initializeLLVM();
+  // Drops the builder and the lookup tables, which point into the IR moved to the JIT.
+  void releaseIR();
+
+  // ===============================================================================================
+  // Floating point semantics
+
+  llvm::FastMathFlags getFastMathFlags() const;
+  void applyFastMathAttributes(llvm::Function* function);
+
+  // ===============================================================================================
+  // Debug info
+
+  // Returns the debug file of a source path, the input file if it is empty.
+  llvm::DIFile* getDebugFile(const std::string& path);
+  void emitFunctionDebugInfo(llvm::Function* function, int line, llvm::DIFile* file);
+  // Attaches the source line of a statement to the instructions created from now on.
+  void emitDebugLocation(int line);
+
+  void beginRunFunction();
+  void codegenTopLevel(ASTNode* node, int line);
+  void finishRunFunction();
 
   llvm::Value* codegenExpr(ASTNode* node);
+  // Generates the value of an expression tree without recursing once per tree level.
+  llvm::Value* codegenValue(ASTNode* rootNode);
   llvm::Value* codegenNumber(ASTNode* inputNode);
-  llvm::Value* codegenBinaryOp(ASTNode* inputNode);
+  llvm::Value* codegenInteger(ASTNode* inputNode);
+  llvm::Value* codegenVariable(ASTNode* inputNode);
+  llvm::Value* codegenBinaryOp(ASTNode* inputNode, llvm::Value* leftExpr, llvm::Value* rightExpr);
+  // Integer division defined for every operand: x / 0 is 0 and the minimum value / -1 wraps.
+  llvm::Value* codegenDivision(llvm::Value* leftExpr, llvm::Value* rightExpr);
+  llvm::Value* codegenBuiltinCall(ASTNode* inputNode, std::vector<llvm::Value*> args);
   llvm::Value* codegenAssignment(ASTNode* inputNode);
+  llvm::Value* codegenShow(ASTNode* inputNode);
   llvm::Value* codegenProcedureBody(ASTNode* inputNode);
   llvm::Value* codegenProcedure(ASTNode* inputNode);
   llvm::Value* codegenProcedureCall(ASTNode* inputNode);
+  llvm::Value* codegenParallel(ASTNode* inputNode);
+
+  // Remembers the value of a shared expression to reuse it while the globals it reads do not
+  // change.
+  void cacheValue(ASTNode* node, llvm::Value* value);
+  // Drops the cached values that read the global.
+  void invalidateValues(const std::string& name);
+  void clearValueCache();
+
+  // Code address called for a procedure. In tiered mode it is loaded from the procedure stub.
+  llvm::Value* getProcedureAddress(const std::string& name);
 
   llvm::Function* createFunction(const std::string& name, llvm::FunctionType* type);
   llvm::Function* getFunction(const std::string& name);
@@ -91,7 +241,49 @@ private:
                                      const std::string& parentFunctionName);
   llvm::BasicBlock* getBasicBlock(const std::string& name);
 
-  llvm::GlobalVariable* createGlobalVariable(const std::string& name);
+  // Runtime function that shows values of the given type.
+  llvm::FunctionCallee getShowFunction(llvm::Type* type);
+
+  llvm::GlobalVariable* createGlobalVariable(const std::string& name, llvm::Type* type);
   llvm::GlobalVariable* getGlobalVariable(const std::string& name);
-  llvm::GlobalVariable* getOrCreateGlobalVariable(const std::string& name);
+  llvm::GlobalVariable* getOrCreateGlobalVariable(const std::string& name, llvm::Type* type);
+
+  // ===============================================================================================
+  // Types
+
+  llvm::Type* getLLVMType(ValueType type);
+  llvm::Type* getVariableLLVMType(const std::string& name, llvm::Type* fallback);
+  ValueType getValueTypeOf(llvm::Value* value);
+  llvm::Value* convertValue(llvm::Value* value, llvm::Type* type);
+
+  // ===============================================================================================
+  // Libraries
+
+  // Reads the index of every library given in the options. Their procedures and globals become
+  // known to the semantic passes, no code is loaded.
+  void importLibraries();
+  // Declares a procedure of an imported library the first time it is called. Returns nullptr if no
+  // library defines it.
+  llvm::Function* declareImportedProcedure(const std::string& name);
+  // Links the bodies of the declared library procedures, and of the procedures they call, into the
+  // module.
+  void linkLibraries();
+
+  // ===============================================================================================
+  // Runtime
+
+  llvm::Error defineRuntimeSymbols(llvm::orc::LLJIT& jit);
+
+  // Maps the state file with a slot for every global of the program.
+  std::unique_ptr<StateFile> openState();
+  // Links the globals of the program to their slots in the state file.
+  llvm::Error defineStateSymbols(llvm::orc::LLJIT& jit, const StateFile& state);
+
+  // ===============================================================================================
+  // Profile guided optimization
+
+  void emitProfileCounter(const std::string& functionName);
+  void emitProcedureStub(llvm::Function* function);
+  void applyProfile();
+  void writeProfile(llvm::orc::LLJIT& jit);
 };
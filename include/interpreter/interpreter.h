@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ast/ast.h"
+#include "options.h"
+#include "semantic/parallel_checker.h"
+#include "semantic/type_checker.h"
+
+/**
+ * @brief Runs a program without LLVM by translating its AST into a compact stack bytecode.
+ * Programs behave as with the JIT: values keep their i64, f32 or f64 type, integers wrap around,
+ * procedures must be defined before they are called and the show and parallel runtimes are the
+ * same ones the generated code calls. Used for short programs, where starting the JIT takes much
+ * longer than running them.
+ *
+ */
+class Interpreter {
+public:
+  Interpreter(ASTNode* rootNode, CompilerOptions options = CompilerOptions());
+
+  // Checks the program and translates it to bytecode. Invalid programs throw like
+  // Compiler::generateCode().
+  void compile();
+
+  // Estimated number of instructions executed by a run of the compiled program. Procedures that
+  // can call themselves make it UINT64_MAX.
+  uint64_t getEstimatedCost() const;
+
+  // Runs the compiled program and returns the value of "ret" as f64, like the JIT run function.
+  double execute();
+  // Runs the compiled program and returns its exit code, like Compiler::runJIT().
+  int run();
+
+  // Value of a global variable converted to f64. Variables that do not exist are 0.
+  double getGlobal(const std::string& name) const;
+
+private:
+  union Value {
+    int64_t i64;
+    float f32;
+    double f64;
+  };
+
+  enum class OpCode : uint8_t {
+    Constant,
+    Load,
+    Store,
+    Pop,
+    I64ToF32,
+    I64ToF64,
+    F32ToI64,
+    F64ToI64,
+    F32ToF64,
+    F64ToF32,
+    AddI64,
+    SubI64,
+    MulI64,
+    DivI64,
+    AddF32,
+    SubF32,
+    MulF32,
+    DivF32,
+    AddF64,
+    SubF64,
+    MulF64,
+    DivF64,
+    // The operand is the Builtin.
+    BuiltinI64,
+    BuiltinF32,
+    BuiltinF64,
+    // The operand is the separator written after the value.
+    ShowI64,
+    ShowF32,
+    ShowF64,
+    // The operand is the index of the procedure.
+    Call,
+    // The operand is the index of the parallel block.
+    Parallel,
+    Return
+  };
+
+  struct Instruction {
+    OpCode code;
+    uint32_t operand;
+    Value value;
+  };
+
+  struct Procedure {
+    std::string name;
+    std::vector<Instruction> code;
+    // Estimated instructions executed per call. Only known once the procedure is compiled.
+    uint64_t cost = 0;
+    bool compiled = false;
+  };
+
+  struct Global {
+    ValueType type;
+    Value value;
+  };
+
+  ASTNode* rootNode;
+  CompilerOptions options;
+
+  TypeChecker typeChecker;
+  ParallelChecker parallelChecker;
+
+  // Procedure 0 is the body of the program, the rest are indexed by procedureTable.
+  std::vector<Procedure> procedures;
+  std::unordered_map<std::string, uint32_t> procedureTable;
+  // Procedures called by each parallel block.
+  std::vector<std::vector<uint32_t>> parallelBlocks;
+
+  std::vector<Global> globals;
+  std::unordered_map<std::string, uint32_t> globalTable;
+
+  void compileStatement(ASTNode* node, uint32_t procedure);
+  // Emits the code leaving the value of an expression on the stack, without recursing once per
+  // tree level.
+  void compileValue(ASTNode* rootNode, uint32_t procedure);
+  void compileProcedure(ASTNode* node);
+  void emit(uint32_t procedure, OpCode code, uint32_t operand = 0, Value value = {});
+  void emitConversion(uint32_t procedure, ValueType from, ValueType to);
+  void finishProcedure(uint32_t procedure);
+
+  uint32_t getProcedureIndex(const std::string& name) const;
+  uint32_t getOrCreateGlobal(const std::string& name);
+
+  // Runs a procedure to its end. Calls are kept in an explicit frame stack.
+  void executeProcedure(uint32_t procedure);
+};
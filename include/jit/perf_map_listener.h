@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <llvm/ExecutionEngine/JITEventListener.h>
+#include <llvm/ExecutionEngine/RuntimeDyld.h>
+#include <llvm/Object/ObjectFile.h>
+#include <mutex>
+#include <string>
+
+/**
+ * @brief Writes the address, size and name of every JIT compiled function to the perf map file of
+ * the process (/tmp/perf-<pid>.map), so that `perf report` can name the samples taken in JIT code.
+ * Entries are never removed, perf keeps the last one seen for an address.
+ *
+ */
+class PerfMapListener : public llvm::JITEventListener {
+public:
+  // Uses the default path of the running process when path is empty.
+  explicit PerfMapListener(std::string path = "");
+
+  void notifyObjectLoaded(ObjectKey key, const llvm::object::ObjectFile& object,
+                          const llvm::RuntimeDyld::LoadedObjectInfo& loadedInfo) override;
+
+  const std::string& getPath() const { return this->path; }
+
+  // Line of the perf map format for one function.
+  static std::string formatEntry(uint64_t address, uint64_t size, const std::string& name);
+
+private:
+  std::string path;
+  std::ofstream file;
+  // Objects are loaded by the main thread and by the tiered compilation thread.
+  std::mutex mutex;
+};
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Target/TargetMachine.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Background recompilation of hot procedures.
+ * The module is first compiled without optimizations and every procedure call goes through a stub
+ * global holding the address of its code. A background thread watches the entry counters of the
+ * procedures and, once one reaches the threshold, compiles it again at -O3 and swaps the stub to
+ * the new code.
+ *
+ */
+class TieredJIT {
+public:
+  // Must be created before the module is moved into the JIT, as it keeps a bitcode copy of it.
+  // With keepCounters the optimized code still counts its calls, e.g. to write a profile.
+  // fuseFPOperations and vectorLibrary are the backend and vectorizer settings the rest of the
+  // program was compiled with.
+  TieredJIT(llvm::orc::LLJIT& jit, const llvm::Module& module, std::vector<std::string> procedures,
+            uint64_t threshold, bool keepCounters, bool fuseFPOperations,
+            std::string vectorLibrary);
+
+  ~TieredJIT() { this->stop(); }
+
+  // Start and stop the background thread. start() requires the module to be materialized.
+  void start();
+  void stop();
+
+  size_t getPromotedCount() const { return this->promotedCount.load(); }
+
+private:
+  // Per procedure state. Addresses point to the globals inside the JIT memory.
+  struct Procedure {
+    std::string name;
+    uint64_t* counter = nullptr;
+    void** stub = nullptr;
+    bool promoted = false;
+  };
+
+  llvm::orc::LLJIT& jit;
+  uint64_t threshold;
+  bool keepCounters;
+  // Let the backend fuse multiplications and additions, as with --fp-contract.
+  bool fuseFPOperations;
+  // Vector math library used by the vectorizers, empty for none.
+  std::string vectorLibrary;
+
+  // Bitcode of the unoptimized module, parsed again for each recompilation.
+  llvm::SmallVector<char, 0> bitcode;
+  std::vector<Procedure> procedures;
+
+  // Target machine generating optimized machine code for the promoted procedures.
+  std::unique_ptr<llvm::TargetMachine> targetMachine;
+
+  std::thread worker;
+  std::mutex mutex;
+  std::condition_variable wakeUp;
+  bool stopRequested = false;
+  std::atomic<size_t> promotedCount{0};
+
+  void watchCounters();
+  bool promote(Procedure& procedure);
+};
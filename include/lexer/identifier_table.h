@@ -0,0 +1,8 @@
+#pragma once
+
+#include <string_view>
+
+// Returns a NUL terminated copy of the identifier that lives until the calling thread exits. Equal
+// identifiers share the same copy, so the lexers allocate once per distinct identifier instead of
+// once per token.
+const char* internIdentifier(std::string_view identifier);
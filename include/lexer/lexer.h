@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+
+enum class TokenKind {
+  End,
+  Save,
+  In,
+  Create,
+  Done,
+  Show,
+  Parallel,
+  Number,
+  FNumber,
+  Integer,
+  Word,
+  Arrow,
+  Newline,
+  // Any other character, including the operators.
+  Char,
+  // Invalid token, already reported. E.g. an integer out of range.
+  Error
+};
+
+struct Token {
+  TokenKind kind = TokenKind::End;
+  // Line where the token starts. A newline token belongs to the line it opens, as in scanner.l.
+  int line = 0;
+  union {
+    double number;
+    long long integer;
+    // Interned, see internIdentifier().
+    const char* word;
+    char character;
+  };
+
+  Token() : integer(0) {}
+};
+
+/**
+ * @brief Hand-written lexer producing the same tokens as the Flex scanner in scanner.l.
+ * Whitespace and words are scanned 16 bytes at a time with SSE2 or NEON when available, numbers
+ * are converted with std::from_chars and words are interned, so reading a token does not allocate.
+ * Files are read in chunks of whole lines, as no token spans two lines, so the memory used does
+ * not grow with the size of the input.
+ *
+ */
+class Lexer {
+public:
+  // Bytes after the end of the text that the vectorized scans may read.
+  static constexpr size_t paddingSize = 16;
+
+  // Lexes a whole text.
+  explicit Lexer(std::string text);
+  // Lexes a file, reading the next lines once the previous ones are consumed. Reading a pipe or a
+  // terminal only waits for the lines being lexed.
+  explicit Lexer(FILE* input);
+
+  // The cursor points into the owned text.
+  Lexer(const Lexer&) = delete;
+  Lexer& operator=(const Lexer&) = delete;
+
+  Token next();
+
+  int getLine() const { return this->line; }
+  void setLine(int line) { this->line = line; }
+
+private:
+  // Maximum number of bytes read from the file at once.
+  static constexpr size_t chunkSize = 64 * 1024;
+
+  // Lines being lexed followed by the padding.
+  std::string text;
+  const char* cursor;
+  const char* end;
+  int line = 1;
+  // Whether the last token is a number, so that a '-' right after it is the operator.
+  bool afterNumber = false;
+
+  // File being read, nullptr once it ends or when lexing a text.
+  FILE* input = nullptr;
+  // Start of a line read after the last complete line of the buffer.
+  std::string pending;
+
+  void setText(std::string text);
+  // Replaces the consumed buffer with the next complete lines of the file. Returns false at the end
+  // of the input.
+  bool refill();
+};
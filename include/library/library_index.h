@@ -0,0 +1,45 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ast/ast.h"
+
+// Suffix added to the path of a library bitcode file to get the path of its index.
+inline const std::string libraryIndexSuffix = ".index";
+
+/**
+ * @brief Symbol index of a precompiled hebe library.
+ * Lists the procedures defined in the bitcode of the library, with the globals each one reads and
+ * writes, and the type of every global they use. Importing a library only reads its index. The
+ * bitcode is opened once a procedure is called and only the procedures in use are loaded from it.
+ *
+ */
+class LibraryIndex {
+public:
+  struct Procedure {
+    std::string name;
+    // Globals accessed by the procedure and the procedures it calls.
+    std::vector<std::string> reads;
+    std::vector<std::string> writes;
+  };
+
+  void addGlobal(const std::string& name, ValueType type) { globals[name] = type; }
+  void addProcedure(Procedure procedure);
+
+  const std::unordered_map<std::string, ValueType>& getGlobals() const { return globals; }
+  const std::vector<Procedure>& getProcedures() const { return procedures; }
+  // Returns nullptr if the library does not define the procedure.
+  const Procedure* getProcedure(const std::string& name) const;
+
+  void writeToFile(const std::string& fileName) const;
+  static LibraryIndex readFromFile(const std::string& fileName);
+
+private:
+  // Table containing global name <std::string> and type <ValueType> of every global used.
+  std::unordered_map<std::string, ValueType> globals;
+  std::vector<Procedure> procedures;
+  // Table containing procedure name <std::string> and position <size_t> in procedures.
+  std::unordered_map<std::string, size_t> procedurePositions;
+};
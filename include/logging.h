@@ -3,9 +3,21 @@
 #include <memory>
 #include <spdlog/spdlog.h>
 
+// Trace and debug calls go through these macros so that builds with a higher SPDLOG_ACTIVE_LEVEL
+// remove them at compile time, arguments included.
+#define HEBE_LOG_TRACE(...) SPDLOG_LOGGER_TRACE(logsys::get(), __VA_ARGS__)
+#define HEBE_LOG_DEBUG(...) SPDLOG_LOGGER_DEBUG(logsys::get(), __VA_ARGS__)
+
 namespace logsys {
 inline std::string loginPattern = "[%Y-%m-%d %H:%M:%S.%e] [%^%l%$] %v";
-void configureShinks();
-void init();
-std::shared_ptr<spdlog::logger> get();
+// Number of messages the asynchronous logger keeps before overwriting the oldest ones.
+inline constexpr size_t asyncQueueSize = 8192;
+
+// Creating or replacing the logger is not thread safe. It is done before starting any thread that
+// logs.
+void configureShinks(bool async = false);
+void init(bool async = false);
+void shutdown();
+// Logger created by init() or configureShinks().
+const std::shared_ptr<spdlog::logger>& get();
 } // namespace logsys
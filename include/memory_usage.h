@@ -0,0 +1,9 @@
+#pragma once
+
+#include <cstdint>
+
+// Resident set size of the process in bytes, 0 if it can not be read.
+uint64_t getResidentMemory();
+
+// Returns the free memory of the heap to the operating system where the allocator supports it.
+void trimHeap();
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <llvm/IR/Module.h>
+#include <llvm/Target/TargetMachine.h>
+#include <string>
+
+/**
+ * @brief Runs the default LLVM module pipeline for the given optimization level.
+ * Level 0 leaves the module untouched. When a target machine is given the passes can use its cost
+ * model. When a vector math library is given the vectorizers can replace math intrinsics with its
+ * vector functions.
+ *
+ */
+void optimizeModule(llvm::Module& module, unsigned optLevel,
+                    llvm::TargetMachine* targetMachine = nullptr,
+                    const std::string& vectorLibrary = "");
+
+// Shared library providing the functions of a vector math library, nullptr if the name is unknown.
+const char* getVectorLibraryPath(const std::string& name);
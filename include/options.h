@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Engine running the program.
+enum class ExecutionMode {
+  // The interpreter for programs estimated to run few instructions, the JIT for the rest.
+  Auto,
+  JIT,
+  Interpreter
+};
+
+/**
+ * @brief Options that change how a hebe program is compiled and executed.
+ * They are filled from the command line by parseOptions().
+ *
+ */
+struct CompilerOptions {
+  // Path to the .hebe file to compile. Empty means reading from stdin.
+  std::string inputFile;
+
+  // Compile the input files into a library instead of running them. The bitcode is written to this
+  // path and the symbol index next to it. Empty runs the program.
+  std::string libraryOutput;
+  // Files compiled into the library after inputFile.
+  std::vector<std::string> libraryInputFiles;
+  // Bitcode files of the libraries whose procedures the program can call.
+  std::vector<std::string> libraries;
+
+  // Optimization level of the IR pipeline. 0 skips the pipeline.
+  unsigned optLevel = 0;
+  // Vector math library used by the vectorizers for math functions (SVML, SLEEF, ArmPL, AMDLIBM,
+  // Accelerate). Empty only vectorizes the math functions that LLVM can expand inline.
+  std::string vectorLibrary;
+
+  // Relaxed floating point semantics for the generated code. --fast-math enables all of them and
+  // also ignores the sign of zero and allows approximate math functions.
+  bool fastMath = false;
+  // Fuse multiplications and additions into fma.
+  bool fpContract = false;
+  // Reassociate operations, e.g. to vectorize sums.
+  bool fpReassoc = false;
+  // Assume that no operand or result is NaN.
+  bool fpNoNaNs = false;
+  // Assume that no operand or result is infinite.
+  bool fpNoInfs = false;
+  // Allow x / y to be computed as x * (1 / y).
+  bool fpApproxRecip = false;
+
+  // File where an instrumented run writes its profile. Empty disables instrumentation.
+  std::string profileGenerate;
+  // Profile file used to guide the optimizer. Empty disables profile guided optimization. Selects
+  // -O2 when no optimization level is given.
+  std::string profileUse;
+
+  // Compile everything without optimizations first and recompile hot procedures at -O3 in a
+  // background thread.
+  bool tiered = false;
+  // Number of calls after which a procedure is recompiled in tiered mode.
+  uint64_t tierUpThreshold = 1000;
+
+  // Free the AST after code generation and the IR once it is compiled, and pack the JIT code into
+  // few pages. Reports the resident memory before and after.
+  bool lowMemory = false;
+
+  // Emit debug info mapping the generated code to the lines of the .hebe file.
+  bool debugInfo = false;
+  // Register the JIT code with Linux perf, writing /tmp/perf-<pid>.map and, when LLVM supports it,
+  // a jitdump file with line tables. Implies debugInfo.
+  bool perf = false;
+  // Register the JIT code with the GDB JIT interface. Implies debugInfo.
+  bool gdb = false;
+
+  // File keeping the global variables between runs. The program starts from the values of the last
+  // run and saves them when it ends. Empty starts every variable at zero.
+  std::string stateFile;
+  // Start from the state file without saving the values at the end.
+  bool stateReadOnly = false;
+
+  // Engine running the program. The options that only apply to generated code and imported
+  // libraries select the JIT in auto mode.
+  ExecutionMode executionMode = ExecutionMode::Auto;
+  // Maximum estimated number of bytecode instructions executed by a program that auto mode runs
+  // in the interpreter.
+  uint64_t interpreterThreshold = 1000000;
+
+  // Number of threads running the procedures of parallel blocks. 0 uses one per hardware thread.
+  uint64_t threads = 0;
+
+  // File where the per-phase trace events are written in Chrome trace format. Empty disables it.
+  std::string traceFile;
+  // Format and write log messages in a background thread.
+  bool asyncLog = false;
+  // Minimum level of the printed log messages (trace, debug, info, warn, error).
+  std::string logLevel = "info";
+
+  // Generate code for each top level item as soon as it is parsed and free it afterwards.
+  bool stream = false;
+  // Run the parser in its own thread when streaming.
+  bool streamThreads = false;
+  // Maximum number of parsed items waiting for code generation when streaming with threads.
+  uint64_t streamQueueCapacity = 1024;
+};
+
+CompilerOptions parseOptions(int argc, char** argv);
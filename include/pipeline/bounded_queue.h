@@ -0,0 +1,57 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+/**
+ * @brief Blocking FIFO queue with a maximum size, used to connect two pipeline threads.
+ * push() blocks while the queue is full and pop() blocks while it is empty. Once closed, push()
+ * fails and pop() returns the remaining elements and then an empty optional.
+ *
+ */
+template <typename T> class BoundedQueue {
+public:
+  explicit BoundedQueue(size_t capacity) : capacity(capacity ? capacity : 1) {}
+
+  bool push(T value) {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->notFull.wait(lock, [this] { return this->closed || this->items.size() < this->capacity; });
+    if (this->closed)
+      return false;
+
+    this->items.push_back(std::move(value));
+    this->notEmpty.notify_one();
+    return true;
+  }
+
+  std::optional<T> pop() {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->notEmpty.wait(lock, [this] { return this->closed || !this->items.empty(); });
+    if (this->items.empty())
+      return std::nullopt;
+
+    T value = std::move(this->items.front());
+    this->items.pop_front();
+    this->notFull.notify_one();
+    return value;
+  }
+
+  void close() {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->closed = true;
+    this->notFull.notify_all();
+    this->notEmpty.notify_all();
+  }
+
+private:
+  size_t capacity;
+  bool closed = false;
+  std::deque<T> items;
+  std::mutex mutex;
+  std::condition_variable notFull;
+  std::condition_variable notEmpty;
+};
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstddef>
+
+#include "compiler.h"
+
+/**
+ * @brief Parses the input and generates code for each top level item as soon as it is parsed.
+ * Items are freed right after their code is generated, so the AST memory does not grow with the
+ * size of the program. When threaded is set, parsing runs in its own thread and hands items to
+ * the code generation thread through a queue of at most queueCapacity items.
+ *
+ * @return The result of yyparse().
+ */
+int parseAndGenerateStreamed(Compiler& compiler, bool threaded, size_t queueCapacity);
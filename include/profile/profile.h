@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+/**
+ * @brief Execution profile of a hebe program.
+ * Stores how many times each procedure was entered during an instrumented run. The entry function
+ * "run" is stored as any other procedure.
+ *
+ */
+class Profile {
+public:
+  void setCount(const std::string& name, uint64_t count) { counts[name] = count; }
+  bool contains(const std::string& name) const { return counts.find(name) != counts.end(); }
+  uint64_t getCount(const std::string& name) const;
+  uint64_t getMaxCount() const;
+  size_t size() const { return counts.size(); }
+
+  void writeToFile(const std::string& fileName) const;
+  static Profile readFromFile(const std::string& fileName);
+
+private:
+  // Table containing procedure name <std::string> and its entry count <uint64_t>.
+  std::unordered_map<std::string, uint64_t> counts;
+};
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+// Sets the number of worker threads of the pool running parallel blocks. 0 uses one per hardware
+// thread. Only has effect before the first parallel block runs.
+void configureParallelRuntime(size_t threadCount);
+
+// Runtime functions called by the generated code for parallel blocks. A block begins a task group,
+// spawns one task per procedure call and joins the group at its end.
+extern "C" {
+void* hebe_parallel_begin();
+void hebe_parallel_spawn(void* group, void (*procedure)());
+void hebe_parallel_join(void* group);
+}
+
+// Spawns a task that is not a JIT compiled procedure, e.g. a procedure run by the interpreter, in a
+// group started with hebe_parallel_begin().
+void spawnParallelTask(void* group, std::function<void()> task);
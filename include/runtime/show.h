@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Size of the per-thread buffer where the output of show is collected before being written.
+inline constexpr size_t showBufferSize = 1 << 20;
+
+// Runtime functions called by the generated code for the show statement. Each one formats a
+// value into the buffer of the calling thread followed by the given separator character.
+// The buffer is written to stdout when it is nearly full, when hebe_show_flush() is called and
+// when the thread exits.
+extern "C" {
+void hebe_show_i64(int64_t value, int32_t separator);
+void hebe_show_f32(float value, int32_t separator);
+void hebe_show_f64(double value, int32_t separator);
+void hebe_show_flush();
+}
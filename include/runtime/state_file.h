@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ast/ast.h"
+
+// Version of the layout of state files. Files with another version are rejected.
+inline constexpr uint32_t stateFileVersion = 1;
+
+/**
+ * @brief Global variables of a program kept in a file between runs.
+ * The file holds an index of the variables and one 8 byte slot per value, starting at a page
+ * boundary. It is mapped copy-on-write, so a run starts from the last checkpoint without reading or
+ * converting anything, and the pages it does not write stay shared with other processes through
+ * the page cache. checkpoint() replaces the file atomically with the current values.
+ *
+ */
+class StateFile {
+public:
+  struct Variable {
+    std::string name;
+    ValueType type;
+  };
+
+  // Maps the state at path with a slot for every given variable. A missing file starts with every
+  // value at zero. Variables of the file not in the list are kept, and the ones whose type changed
+  // start again from zero.
+  StateFile(std::string path, const std::vector<Variable>& variables);
+  ~StateFile();
+
+  // The slots point into the mapping.
+  StateFile(const StateFile&) = delete;
+  StateFile& operator=(const StateFile&) = delete;
+
+  // Address of the value of a variable, nullptr if it is not in the state.
+  void* getSlot(const std::string& name) const;
+  // Number of checkpoints made since the file was created.
+  uint64_t getGeneration() const;
+
+  // Writes the current values to a new file and renames it over the state file. Readers see
+  // either the previous or the new snapshot, never a mix of both.
+  void checkpoint();
+
+private:
+  struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t variableCount;
+    uint64_t generation;
+    // Offset of the first value slot, aligned to a page.
+    uint64_t valuesOffset;
+    uint64_t size;
+  };
+
+  struct Entry {
+    uint64_t nameOffset;
+    uint32_t nameLength;
+    uint32_t type;
+  };
+
+  struct Slot {
+    size_t offset;
+    ValueType type;
+  };
+
+  std::string path;
+  char* data = nullptr;
+  size_t size = 0;
+  // Table containing variable name <std::string> and value slot <Slot> of every variable.
+  std::unordered_map<std::string, Slot> slots;
+
+  Header* getHeader() const { return reinterpret_cast<Header*>(this->data); }
+
+  // Maps the existing file and indexes its variables. Returns false if the file does not exist.
+  bool map();
+  // Lays out the state again with the given variables added, keeping the values of the others.
+  void rebuild(const std::vector<Variable>& variables);
+  void unmap();
+};
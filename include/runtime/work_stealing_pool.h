@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Thread pool where every worker owns a queue of tasks and idle workers steal from the
+ * others.
+ * Workers run their own newest task first and steal the oldest task of another worker, so nested
+ * groups stay local while independent work spreads over all the threads. A thread waiting in
+ * join() runs pending tasks meanwhile, so groups can be joined from inside a task.
+ *
+ */
+class WorkStealingPool {
+public:
+  using Task = std::function<void()>;
+
+  // Tasks spawned together and waited for with join().
+  class TaskGroup {
+  public:
+    TaskGroup() = default;
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+  private:
+    friend class WorkStealingPool;
+    std::atomic<size_t> pending{0};
+    std::mutex mutex;
+    std::condition_variable done;
+  };
+
+  // A worker count of 0 uses one worker per hardware thread.
+  explicit WorkStealingPool(size_t workerCount = 0);
+  ~WorkStealingPool();
+
+  WorkStealingPool(const WorkStealingPool&) = delete;
+  WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+  void spawn(TaskGroup& group, Task task);
+  // Returns once every task spawned in the group has finished.
+  void join(TaskGroup& group);
+
+  size_t getWorkerCount() const { return this->queues.size(); }
+
+private:
+  struct PendingTask {
+    Task task;
+    TaskGroup* group;
+  };
+
+  struct WorkerQueue {
+    std::mutex mutex;
+    std::deque<PendingTask> tasks;
+  };
+
+  std::vector<std::unique_ptr<WorkerQueue>> queues;
+  std::vector<std::thread> workers;
+
+  // Idle workers sleep until tasks are queued or the pool stops.
+  std::mutex sleepMutex;
+  std::condition_variable wakeUp;
+  size_t queuedTasks = 0;
+  bool stopRequested = false;
+
+  // Queue where threads that are not workers of the pool spawn their tasks.
+  WorkerQueue externalQueue;
+
+  void workerLoop(size_t index);
+  std::optional<PendingTask> findTask();
+  void runTask(PendingTask& pendingTask);
+};
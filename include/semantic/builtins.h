@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include "ast/ast.h"
+
+// Math functions built into the language. They are lowered to LLVM intrinsics so that the
+// optimizer can fold, inline and vectorize them.
+enum class Builtin { Sqrt, Abs, Min, Max, Fma, Floor, Exp, Log, Pow, Sin, Cos };
+
+struct BuiltinInfo {
+  Builtin id;
+  const char* name;
+  size_t arity;
+  // Whether the function has an integer version. Other functions convert i64 arguments to f64.
+  bool integerVersion;
+};
+
+// Returns the built-in with the given name or nullptr if there is none.
+const BuiltinInfo* findBuiltin(const std::string& name);
+
+// Type returned by a built-in called with arguments of the given joined type.
+ValueType getBuiltinResultType(const BuiltinInfo& builtin, ValueType argumentsType);
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "ast/ast.h"
+
+/**
+ * @brief Semantic pass that rejects parallel blocks whose procedures could race on a global.
+ * The globals read and written by each procedure are collected, including the ones of the
+ * procedures it calls. Two calls of the same parallel block conflict when one of them writes a
+ * global that the other reads or writes.
+ *
+ */
+class ParallelChecker {
+public:
+  void check(ASTNode* rootNode);
+  // Checks one top level item of a streamed program. Procedures must be created before use.
+  void checkItem(ASTNode* node);
+
+  struct Accesses {
+    std::unordered_set<std::string> reads;
+    std::unordered_set<std::string> writes;
+  };
+
+  // Registers a procedure defined elsewhere, like the procedures of an imported library.
+  void declareProcedure(const std::string& name, Accesses accesses);
+  // Globals accessed by a procedure, nullptr if it is unknown.
+  const Accesses* getProcedureAccesses(const std::string& name) const;
+
+private:
+  // Table containing name <std::string> and globals accessed <Accesses> of every procedure.
+  std::unordered_map<std::string, Accesses> procedureTable;
+
+  // Adds the globals accessed by a statement. Procedure definitions access nothing themselves,
+  // they only register the accesses of the procedure.
+  void visit(ASTNode* node, Accesses& accesses);
+  void visitExpr(ASTNode* node, Accesses& accesses);
+  void checkParallel(ASTNode* node);
+};
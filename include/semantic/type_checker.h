@@ -0,0 +1,46 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "ast/ast.h"
+
+/**
+ * @brief Semantic pass that infers the type of every expression and global variable.
+ * Literals fix their own type, binary operations take the widest type of their operands and a
+ * variable takes the widest type of all the values assigned to it anywhere in the program.
+ * Expression nodes are annotated with their type in ASTNode::valueType.
+ *
+ */
+class TypeChecker {
+public:
+  void check(ASTNode* rootNode);
+  // Checks one top level item of a streamed program. Variables keep the type of their first
+  // assignment and must be assigned before being read.
+  void checkItem(ASTNode* node);
+  // Declares a variable whose type is fixed, like the globals of an imported library. Assignments
+  // convert their value to it instead of widening it.
+  void declareVariable(const std::string& name, ValueType type);
+
+  ValueType getVariableType(const std::string& name) const;
+  const std::unordered_map<std::string, ValueType>& getVariableTypes() const {
+    return this->variableTypeTable;
+  }
+
+private:
+  // Table containing name <std::string> and inferred type <ValueType> of all global variables.
+  std::unordered_map<std::string, ValueType> variableTypeTable;
+  // Names of the variables declared with a fixed type.
+  std::unordered_set<std::string> fixedVariables;
+
+  // Set when a pass widens the type of any variable.
+  bool changed = false;
+  // Set by checkItem(). Later items can not change types already used by generated code.
+  bool incremental = false;
+  // Name of a variable read before its type is known, empty if there is none.
+  std::string unknownVariable;
+
+  void visit(ASTNode* node);
+  ValueType visitExpr(ASTNode* node);
+};
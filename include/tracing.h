@@ -0,0 +1,42 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+
+// Records the enclosing scope as a trace event when tracing is enabled.
+#define HEBE_TRACE_SCOPE(name) HEBE_TRACE_SCOPE_AT(name, __LINE__)
+#define HEBE_TRACE_SCOPE_AT(name, line) HEBE_TRACE_SCOPE_NAMED(name, line)
+#define HEBE_TRACE_SCOPE_NAMED(name, line) tracing::Scope traceScope##line(name)
+
+namespace tracing {
+
+void enable();
+// Stops recording new events. The recorded ones are kept until clear().
+void disable();
+bool isEnabled();
+void clear();
+size_t getEventCount();
+
+// Writes all recorded events in the Chrome trace event format (chrome://tracing, Perfetto).
+void writeChromeTrace(const std::string& fileName);
+
+/**
+ * @brief Measures the lifetime of the object as one trace event.
+ * When tracing is disabled the constructor and destructor only check a flag.
+ *
+ */
+class Scope {
+public:
+  explicit Scope(const char* name);
+  ~Scope();
+
+  Scope(const Scope&) = delete;
+  Scope& operator=(const Scope&) = delete;
+
+private:
+  const char* name;
+  bool active;
+  std::chrono::steady_clock::time_point start;
+};
+
+} // namespace tracing
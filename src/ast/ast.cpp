@@ -1,21 +1,66 @@
 #include "ast/ast.h"
 
+void ASTNode::deleteChildren() {
+  std::vector<ASTNode*> pending;
+  this->takeChildren(pending);
+
+  // Every node gives away its children before being deleted, so its destructor has nothing left
+  // to free and never recurses. Shared nodes only lose one of their references.
+  while (!pending.empty()) {
+    ASTNode* node = pending.back();
+    pending.pop_back();
+    if (!node || --node->references > 0)
+      continue;
+    node->takeChildren(pending);
+    delete node;
+  }
+}
+
 std::string getNodeType(NodeType type) {
   switch (type) {
   case NodeType::Program:
     return "Program";
   case NodeType::Number:
     return "Number";
+  case NodeType::Integer:
+    return "Integer";
+  case NodeType::Variable:
+    return "Variable";
   case NodeType::BinaryOp:
     return "BinaryOp";
+  case NodeType::BuiltinCall:
+    return "BuiltinCall";
   case NodeType::Assignment:
     return "Assignment";
+  case NodeType::Show:
+    return "Show";
   case NodeType::ProcedureBody:
     return "ProcedureBody";
   case NodeType::Procedure:
     return "Procedure";
   case NodeType::ProcedureCall:
     return "ProcedureCall";
+  case NodeType::Parallel:
+    return "Parallel";
   }
   return "Unknown";
+}
+
+std::string getValueType(ValueType type) {
+  switch (type) {
+  case ValueType::Unknown:
+    return "unknown";
+  case ValueType::I64:
+    return "i64";
+  case ValueType::F32:
+    return "f32";
+  case ValueType::F64:
+    return "f64";
+  }
+  return "unknown";
+}
+
+ValueType joinValueTypes(ValueType a, ValueType b) {
+  // Unknown types do not constrain the result. Otherwise the widest type wins.
+  return static_cast<int>(a) > static_cast<int>(b) ? a : b;
 }
\ No newline at end of file
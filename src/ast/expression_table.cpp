@@ -0,0 +1,88 @@
+#include "ast/expression_table.h"
+
+#include <cstring>
+#include <vector>
+
+namespace {
+// Appends the bytes of a value to a key.
+template <typename T> void appendBytes(std::string& key, const T& value) {
+  char bytes[sizeof(T)];
+  std::memcpy(bytes, &value, sizeof(T));
+  key.append(bytes, sizeof(T));
+}
+} // namespace
+
+std::string ExpressionTable::getKey(ASTNode* node) {
+  std::string key(1, static_cast<char>(node->type));
+
+  switch (node->type) {
+  case NodeType::Number:
+    // Literals of different types are different values. The bits tell 0.0 and -0.0 apart.
+    key += static_cast<char>(node->valueType);
+    appendBytes(key, static_cast<NumberNode*>(node)->value);
+    break;
+  case NodeType::Integer:
+    appendBytes(key, static_cast<IntegerNode*>(node)->value);
+    break;
+  case NodeType::Variable:
+    key += static_cast<VariableNode*>(node)->name;
+    break;
+  case NodeType::BinaryOp: {
+    BinaryOpNode* binNode = static_cast<BinaryOpNode*>(node);
+    key += binNode->op;
+    appendBytes(key, binNode->left);
+    appendBytes(key, binNode->right);
+    break;
+  }
+  case NodeType::BuiltinCall: {
+    BuiltinCallNode* callNode = static_cast<BuiltinCallNode*>(node);
+    // Names can not contain NUL.
+    key += callNode->name;
+    key += '\0';
+    for (ASTNode* argument : callNode->arguments)
+      appendBytes(key, argument);
+    break;
+  }
+  default:
+    // Statements have effects and are never shared.
+    return std::string();
+  }
+
+  return key;
+}
+
+ASTNode* ExpressionTable::intern(ASTNode* node) {
+  std::string key = getKey(node);
+  if (key.empty())
+    return node;
+
+  auto [it, inserted] = this->nodes.emplace(std::move(key), node);
+  if (inserted)
+    return it->second;
+
+  // The operands of both nodes are the same, so deleting the new one only drops its references to
+  // them.
+  ASTNode* existing = it->second;
+  existing->references++;
+  delete node;
+  return existing;
+}
+
+void ExpressionTable::release(ASTNode* node) {
+  std::vector<ASTNode*> pending{node};
+
+  // Same walk as ASTNode::deleteChildren(), also removing the deleted nodes from the table.
+  while (!pending.empty()) {
+    ASTNode* current = pending.back();
+    pending.pop_back();
+    if (!current || --current->references > 0)
+      continue;
+
+    auto it = this->nodes.find(getKey(current));
+    if (it != this->nodes.end() && it->second == current)
+      this->nodes.erase(it);
+
+    current->takeChildren(pending);
+    delete current;
+  }
+}
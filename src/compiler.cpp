@@ -1,19 +1,84 @@
 #include "compiler.h"
 
+#include <algorithm>
+#include <llvm/BinaryFormat/Dwarf.h>
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/ExecutionEngine/JITEventListener.h>
+#include <llvm/ExecutionEngine/Orc/Core.h>
 #include <llvm/ExecutionEngine/Orc/ExecutionUtils.h>
+#include <llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h>
 #include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/ExecutionEngine/Orc/Mangling.h>
+#include <llvm/ExecutionEngine/Orc/MapperJITLinkMemoryManager.h>
+#include <llvm/ExecutionEngine/Orc/MemoryMapper.h>
+#include <llvm/ExecutionEngine/Orc/ObjectLinkingLayer.h>
+#include <llvm/ExecutionEngine/Orc/RTDyldObjectLinkingLayer.h>
 #include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
+#include <llvm/ExecutionEngine/SectionMemoryManager.h>
 #include <llvm/IR/BasicBlock.h>
+#include <llvm/IR/DebugInfoMetadata.h>
 #include <llvm/IR/DerivedTypes.h>
+#include <llvm/IR/Intrinsics.h>
 #include <llvm/IR/LLVMContext.h>
 #include <llvm/IR/NoFolder.h>
+#include <llvm/Linker/Linker.h>
+#include <llvm/Support/DynamicLibrary.h>
 #include <llvm/Support/Errc.h>
 #include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
 #include <llvm/Support/TargetSelect.h>
+#include <optional>
 #include <stdexcept>
 
 #include "ast/ast.h"
+#include "jit/perf_map_listener.h"
+#include "jit/tiered_jit.h"
+#include "library/library_index.h"
 #include "logging.h"
+#include "memory_usage.h"
+#include "optimizer.h"
+#include "profile/profile.h"
+#include "runtime/parallel.h"
+#include "runtime/show.h"
+#include "runtime/state_file.h"
+#include "semantic/builtins.h"
+#include "tracing.h"
+
+namespace {
+// A procedure is considered hot when it runs at least 1/hotCountDivisor times the hottest one.
+constexpr uint64_t hotCountDivisor = 10;
+// Address space reserved at once by the low memory JIT. Code and data of all the modules are
+// packed into it and only the pages in use become resident.
+constexpr size_t lowMemoryReservation = 16 * 1024 * 1024;
+
+void logResidentMemory(const char* moment) {
+  logsys::get()->info("Resident memory {}: {} KiB", moment, getResidentMemory() / 1024);
+}
+
+llvm::Expected<std::unique_ptr<llvm::orc::ObjectLayer>>
+createCompactObjectLayer(llvm::orc::ExecutionSession& ES) {
+  auto memoryManager =
+      llvm::orc::MapperJITLinkMemoryManager::CreateWithMapper<llvm::orc::InProcessMemoryMapper>(
+          lowMemoryReservation);
+  if (!memoryManager)
+    return memoryManager.takeError();
+  return std::make_unique<llvm::orc::ObjectLinkingLayer>(ES, std::move(*memoryManager));
+}
+
+// RuntimeDyld notifies its listeners of every object it loads, which is how perf and GDB learn
+// where the JIT code is.
+llvm::Expected<std::unique_ptr<llvm::orc::ObjectLayer>>
+createListenedObjectLayer(llvm::orc::ExecutionSession& ES,
+                          const std::vector<llvm::JITEventListener*>& listeners) {
+  auto layer = std::make_unique<llvm::orc::RTDyldObjectLinkingLayer>(
+      ES, [](const llvm::MemoryBuffer&) { return std::make_unique<llvm::SectionMemoryManager>(); });
+  for (llvm::JITEventListener* listener : listeners)
+    layer->registerJITEventListener(*listener);
+  return layer;
+}
+} // namespace
 
 void Compiler::initializeLLVM() {
   this->context = std::make_unique<llvm::LLVMContext>();
@@ -25,6 +90,98 @@ void Compiler::initializeLLVM() {
 #endif
 
   this->module = std::make_unique<llvm::Module>("MainModule", *context);
+
+  // Every floating point operation created by the builder carries the selected fast-math flags.
+  // They are also recorded in the module so that anything built from it knows how it was compiled.
+  llvm::FastMathFlags fastMathFlags = this->getFastMathFlags();
+  this->builder->setFastMathFlags(fastMathFlags);
+  if (fastMathFlags.any())
+    this->module->addModuleFlag(llvm::Module::Warning, fastMathModuleFlag,
+                                static_cast<uint32_t>(fastMathFlags.allowReassoc()) |
+                                    static_cast<uint32_t>(fastMathFlags.noNaNs()) << 1 |
+                                    static_cast<uint32_t>(fastMathFlags.noInfs()) << 2 |
+                                    static_cast<uint32_t>(fastMathFlags.noSignedZeros()) << 3 |
+                                    static_cast<uint32_t>(fastMathFlags.allowReciprocal()) << 4 |
+                                    static_cast<uint32_t>(fastMathFlags.allowContract()) << 5 |
+                                    static_cast<uint32_t>(fastMathFlags.approxFunc()) << 6);
+
+  if (this->options.debugInfo) {
+    this->debugBuilder = std::make_unique<llvm::DIBuilder>(*this->module);
+    this->debugFile = this->getDebugFile("");
+    this->debugBuilder->createCompileUnit(llvm::dwarf::DW_LANG_C, this->debugFile, "hebe",
+                                          this->options.optLevel > 0, "", 0);
+
+    this->module->addModuleFlag(llvm::Module::Warning, "Debug Info Version",
+                                llvm::DEBUG_METADATA_VERSION);
+    this->module->addModuleFlag(llvm::Module::Warning, "Dwarf Version", 4);
+  }
+}
+
+llvm::DIFile* Compiler::getDebugFile(const std::string& path) {
+  const std::string& source = path.empty() ? this->options.inputFile : path;
+  auto found = this->debugFiles.find(source);
+  if (found != this->debugFiles.end())
+    return found->second;
+
+  llvm::SmallString<128> absolute(source.empty() ? "<stdin>" : source);
+  if (!source.empty())
+    llvm::sys::fs::make_absolute(absolute);
+
+  llvm::DIFile* file = this->debugBuilder->createFile(llvm::sys::path::filename(absolute),
+                                                      llvm::sys::path::parent_path(absolute));
+  this->debugFiles[source] = file;
+  return file;
+}
+
+void Compiler::emitFunctionDebugInfo(llvm::Function* function, int line, llvm::DIFile* file) {
+  if (!this->debugBuilder)
+    return;
+
+  // Procedures take no arguments and the values of hebe have no debug types yet.
+  llvm::DISubroutineType* type =
+      this->debugBuilder->createSubroutineType(this->debugBuilder->getOrCreateTypeArray({}));
+  llvm::DISubprogram* subprogram = this->debugBuilder->createFunction(
+      file, function->getName(), function->getName(), file, line, type, line,
+      llvm::DINode::FlagPrototyped, llvm::DISubprogram::SPFlagDefinition);
+  function->setSubprogram(subprogram);
+}
+
+void Compiler::emitDebugLocation(int line) {
+  if (!this->debugBuilder)
+    return;
+
+  llvm::DISubprogram* scope = this->builder->GetInsertBlock()->getParent()->getSubprogram();
+  this->builder->SetCurrentDebugLocation(llvm::DILocation::get(*this->context, line, 0, scope));
+}
+
+llvm::FastMathFlags Compiler::getFastMathFlags() const {
+  llvm::FastMathFlags flags;
+  if (this->options.fastMath) {
+    flags.setFast();
+    return flags;
+  }
+
+  flags.setAllowContract(this->options.fpContract);
+  flags.setAllowReassoc(this->options.fpReassoc);
+  flags.setNoNaNs(this->options.fpNoNaNs);
+  flags.setNoInfs(this->options.fpNoInfs);
+  flags.setAllowReciprocal(this->options.fpApproxRecip);
+  return flags;
+}
+
+void Compiler::applyFastMathAttributes(llvm::Function* function) {
+  // Function attributes used by the code generator for the operations it creates itself.
+  llvm::FastMathFlags flags = this->builder->getFastMathFlags();
+  if (flags.noNaNs())
+    function->addFnAttr("no-nans-fp-math", "true");
+  if (flags.noInfs())
+    function->addFnAttr("no-infs-fp-math", "true");
+  if (flags.noSignedZeros())
+    function->addFnAttr("no-signed-zeros-fp-math", "true");
+  if (flags.approxFunc())
+    function->addFnAttr("approx-func-fp-math", "true");
+  if (flags.isFast())
+    function->addFnAttr("unsafe-fp-math", "true");
 }
 
 void Compiler::printNodeTree(ASTNode* node, int depth) {
@@ -39,61 +196,94 @@ void Compiler::printNodeTree(ASTNode* node, int depth) {
     throw std::runtime_error("Node not initialized. Can not get root node from object.");
   }
 
-  switch (node->type) {
-  case NodeType::Program: {
-    ProgramNode* p = static_cast<ProgramNode*>(node);
-    logsys::get()->info("{}Program:", std::string(depth, 't'));
-    for (ASTNode* child : p->getItems()) {
-      this->printNodeTree(child, depth + 1);
+  // Nodes waiting to be printed with their depth. An explicit stack is used instead of recursion
+  // so that very deep trees can be printed.
+  std::vector<std::pair<ASTNode*, int>> pending{{node, depth}};
+
+  while (!pending.empty()) {
+    auto [current, currentDepth] = pending.back();
+    pending.pop_back();
+
+    // Only called for the messages that are logged.
+    [[maybe_unused]] auto indent = [currentDepth](int extra = 0) {
+      return std::string(currentDepth + extra, '\t');
+    };
+    std::vector<ASTNode*> children;
+
+    switch (current->type) {
+    case NodeType::Program: {
+      HEBE_LOG_DEBUG("{}Program:", indent());
+      children = static_cast<ProgramNode*>(current)->getItems();
+      break;
     }
-    break;
-  }
-  case NodeType::Number: {
-    logsys::get()->info("{}Number: {}", std::string(depth, '\t'),
-                        static_cast<NumberNode*>(node)->value);
-    break;
-  }
-  case NodeType::BinaryOp: {
-    BinaryOpNode* binNode = static_cast<BinaryOpNode*>(node);
-    logsys::get()->info("{}BinaryOp: {}", std::string(depth, '\t'), binNode->op);
-    this->printNodeTree(binNode->left, depth + 1);
-    this->printNodeTree(binNode->right, depth + 1);
-    break;
-  }
-  case NodeType::Assignment: {
-    AssignmentNode* assNNode = static_cast<AssignmentNode*>(node);
-    logsys::get()->info("{}Assignment:", std::string(depth, '\t'));
-    logsys::get()->info("{}VariableName: {}", std::string(depth + 1, '\t'), assNNode->name);
-    this->printNodeTree(assNNode->value, depth + 1);
-    break;
-  }
-  case NodeType::ProcedureBody: {
-    ProcedureBodyNode* procBdyNode = static_cast<ProcedureBodyNode*>(node);
-    logsys::get()->info("{}ProcedureBody:", std::string(depth, '\t'));
-    for (ASTNode* child : procBdyNode->getItems()) {
-      this->printNodeTree(child, depth + 1);
+    case NodeType::Number: {
+      HEBE_LOG_DEBUG("{}Number: {}", indent(), static_cast<NumberNode*>(current)->value);
+      break;
     }
-    break;
-  }
-  case NodeType::Procedure: {
-    ProcedureNode* procNode = static_cast<ProcedureNode*>(node);
-    logsys::get()->info("{}ProcedureNode:", std::string(depth, '\t'));
-    logsys::get()->info("{}Name: {}", std::string(depth + 1, '\t'), procNode->name);
-    this->printNodeTree(procNode->body, depth + 1);
-    break;
-  }
-  case NodeType::ProcedureCall: {
-    ProcedureCallNode* procCallNode = static_cast<ProcedureCallNode*>(node);
-    logsys::get()->info("{}ProcedureCallNode:", std::string(depth, '\t'));
-    logsys::get()->info("{}Name: {}", std::string(depth + 1, '\t'), procCallNode->name);
-    break;
-  }
-  default: {
-    logsys::get()->error("Printing type {} not supported", getNodeType(node->type));
-    break;
-  }
+    case NodeType::Integer: {
+      HEBE_LOG_DEBUG("{}Integer: {}", indent(), static_cast<IntegerNode*>(current)->value);
+      break;
+    }
+    case NodeType::Variable: {
+      HEBE_LOG_DEBUG("{}Variable: {}", indent(), static_cast<VariableNode*>(current)->name);
+      break;
+    }
+    case NodeType::BinaryOp: {
+      BinaryOpNode* binNode = static_cast<BinaryOpNode*>(current);
+      HEBE_LOG_DEBUG("{}BinaryOp: {}", indent(), binNode->op);
+      children = {binNode->left, binNode->right};
+      break;
+    }
+    case NodeType::BuiltinCall: {
+      BuiltinCallNode* callNode = static_cast<BuiltinCallNode*>(current);
+      HEBE_LOG_DEBUG("{}BuiltinCall: {}", indent(), callNode->name);
+      children = callNode->arguments;
+      break;
+    }
+    case NodeType::Assignment: {
+      AssignmentNode* assNNode = static_cast<AssignmentNode*>(current);
+      HEBE_LOG_DEBUG("{}Assignment:", indent());
+      HEBE_LOG_DEBUG("{}VariableName: {}", indent(1), assNNode->name);
+      children = {assNNode->value};
+      break;
+    }
+    case NodeType::Show: {
+      HEBE_LOG_DEBUG("{}Show:", indent());
+      children = static_cast<ShowNode*>(current)->values;
+      break;
+    }
+    case NodeType::ProcedureBody: {
+      HEBE_LOG_DEBUG("{}ProcedureBody:", indent());
+      children = static_cast<ProcedureBodyNode*>(current)->getItems();
+      break;
+    }
+    case NodeType::Procedure: {
+      ProcedureNode* procNode = static_cast<ProcedureNode*>(current);
+      HEBE_LOG_DEBUG("{}ProcedureNode:", indent());
+      HEBE_LOG_DEBUG("{}Name: {}", indent(1), procNode->name);
+      children = {procNode->body};
+      break;
+    }
+    case NodeType::Parallel: {
+      HEBE_LOG_DEBUG("{}Parallel:", indent());
+      children = {static_cast<ParallelNode*>(current)->body};
+      break;
+    }
+    case NodeType::ProcedureCall: {
+      HEBE_LOG_DEBUG("{}ProcedureCallNode:", indent());
+      HEBE_LOG_DEBUG("{}Name: {}", indent(1), static_cast<ProcedureCallNode*>(current)->name);
+      break;
+    }
+    default: {
+      logsys::get()->error("Printing type {} not supported", getNodeType(current->type));
+      break;
+    }
+    }
+
+    // Children are pushed in reverse so that they are printed in order.
+    for (auto it = children.rbegin(); it != children.rend(); ++it)
+      pending.emplace_back(*it, currentDepth + 1);
   }
-  return;
 }
 
 void Compiler::printLLVMIR() {
@@ -141,6 +331,12 @@ llvm::Function* Compiler::createFunction(const std::string& name, llvm::Function
   llvm::Function* funcPtr =
       llvm::Function::Create(type, llvm::Function::ExternalLinkage, name, this->module.get());
 
+  this->applyFastMathAttributes(funcPtr);
+
+  // perf unwinds the JIT code through the frame pointers to build call graphs.
+  if (this->options.perf)
+    funcPtr->addFnAttr("frame-pointer", "all");
+
   // Store the reference pointer into the function map.
   this->functionTable[name] = funcPtr;
 
@@ -186,7 +382,7 @@ llvm::BasicBlock* Compiler::createBasicBlock(const std::string& name,
   return block;
 }
 
-llvm::GlobalVariable* Compiler::createGlobalVariable(const std::string& name) {
+llvm::GlobalVariable* Compiler::createGlobalVariable(const std::string& name, llvm::Type* type) {
 
   // Check if the global variable exist.
   auto it = this->globalVariableTable.find(name);
@@ -196,11 +392,13 @@ llvm::GlobalVariable* Compiler::createGlobalVariable(const std::string& name) {
     throw std::runtime_error("Variable already exists and can not be created");
   }
 
-  // Create the global variable
+  // Create the global variable initialized to zero. With a state file it is only declared, the JIT
+  // links it to its slot in the file. Libraries only declare it, the program importing them
+  // defines it.
+  bool defined = this->options.stateFile.empty() && this->options.libraryOutput.empty();
+  llvm::Constant* initializer = defined ? llvm::Constant::getNullValue(type) : nullptr;
   llvm::GlobalVariable* globalVarPtr = new llvm::GlobalVariable(
-      *this->module, llvm::Type::getFloatTy(*this->context), false,
-      llvm::GlobalValue::ExternalLinkage,
-      llvm::ConstantFP::get(llvm::Type::getFloatTy(*this->context), 0.0), name);
+      *this->module, type, false, llvm::GlobalValue::ExternalLinkage, initializer, name);
 
   // Save the global variable into the global variable table.
   this->globalVariableTable[name] = globalVarPtr;
@@ -220,23 +418,118 @@ llvm::GlobalVariable* Compiler::getGlobalVariable(const std::string& name) {
   return it->second;
 }
 
-llvm::GlobalVariable* Compiler::getOrCreateGlobalVariable(const std::string& name) {
+llvm::GlobalVariable* Compiler::getOrCreateGlobalVariable(const std::string& name,
+                                                          llvm::Type* type) {
   // Return the global variable if exists or create a new one and return it.
   return this->globalVariableTable.find(name) == this->globalVariableTable.end()
-             ? this->createGlobalVariable(name)
+             ? this->createGlobalVariable(name, type)
              : this->globalVariableTable[name];
 }
 
+llvm::Type* Compiler::getLLVMType(ValueType type) {
+  switch (type) {
+  case ValueType::I64:
+    return llvm::Type::getInt64Ty(*this->context);
+  case ValueType::F32:
+    return llvm::Type::getFloatTy(*this->context);
+  case ValueType::F64:
+    return llvm::Type::getDoubleTy(*this->context);
+  default:
+    logsys::get()->error("Type {} has no LLVM representation", getValueType(type));
+    throw std::runtime_error("Type has no LLVM representation");
+  }
+}
+
+llvm::Type* Compiler::getVariableLLVMType(const std::string& name, llvm::Type* fallback) {
+  // Variables not seen by the type checker take the type of their first value.
+  ValueType type = this->typeChecker.getVariableType(name);
+  if (type != ValueType::Unknown)
+    return this->getLLVMType(type);
+
+  if (!fallback) {
+    logsys::get()->error("Type of variable {} is unknown", name);
+    throw std::runtime_error("Type of variable is unknown");
+  }
+
+  return fallback;
+}
+
+ValueType Compiler::getValueTypeOf(llvm::Value* value) {
+  llvm::Type* type = value->getType();
+  if (type->isIntegerTy(64))
+    return ValueType::I64;
+  if (type->isFloatTy())
+    return ValueType::F32;
+  if (type->isDoubleTy())
+    return ValueType::F64;
+  return ValueType::Unknown;
+}
+
+llvm::Value* Compiler::convertValue(llvm::Value* value, llvm::Type* type) {
+  llvm::Type* fromType = value->getType();
+  if (fromType == type)
+    return value;
+
+  // Integer to floating point.
+  if (fromType->isIntegerTy())
+    return this->builder->CreateSIToFP(value, type, "convtmp");
+
+  // Floating point to integer. fptosi is poison out of range, the saturating form clamps to the
+  // integer range and turns NaN into 0.
+  if (type->isIntegerTy())
+    return this->builder->CreateIntrinsic(llvm::Intrinsic::fptosi_sat, {type, fromType}, {value});
+
+  // Between floating point types.
+  return type->getPrimitiveSizeInBits() > fromType->getPrimitiveSizeInBits()
+             ? this->builder->CreateFPExt(value, type, "convtmp")
+             : this->builder->CreateFPTrunc(value, type, "convtmp");
+}
+
 llvm::Value* Compiler::codegenNumber(ASTNode* inputNode) {
   NumberNode* node = static_cast<NumberNode*>(inputNode);
-  return llvm::ConstantFP::get(llvm::Type::getFloatTy(*this->context), node->value);
+  return llvm::ConstantFP::get(this->getLLVMType(node->valueType), node->value);
 }
 
-llvm::Value* Compiler::codegenBinaryOp(ASTNode* inputNode) {
+llvm::Value* Compiler::codegenInteger(ASTNode* inputNode) {
+  IntegerNode* node = static_cast<IntegerNode*>(inputNode);
+  return llvm::ConstantInt::getSigned(llvm::Type::getInt64Ty(*this->context), node->value);
+}
+
+llvm::Value* Compiler::codegenVariable(ASTNode* inputNode) {
+  VariableNode* node = static_cast<VariableNode*>(inputNode);
+
+  llvm::GlobalVariable* variablePtr =
+      this->getOrCreateGlobalVariable(node->name, this->getVariableLLVMType(node->name, nullptr));
+
+  return this->builder->CreateLoad(variablePtr->getValueType(), variablePtr, node->name);
+}
+
+llvm::Value* Compiler::codegenBinaryOp(ASTNode* inputNode, llvm::Value* leftExpr,
+                                       llvm::Value* rightExpr) {
   BinaryOpNode* node = static_cast<BinaryOpNode*>(inputNode);
 
-  llvm::Value* leftExpr = this->codegenExpr(node->left);
-  llvm::Value* rightExpr = this->codegenExpr(node->right);
+  // Convert both operands to the widest of their types.
+  ValueType resultType =
+      joinValueTypes(this->getValueTypeOf(leftExpr), this->getValueTypeOf(rightExpr));
+  leftExpr = this->convertValue(leftExpr, this->getLLVMType(resultType));
+  rightExpr = this->convertValue(rightExpr, this->getLLVMType(resultType));
+
+  // Integers use integer instructions. Division truncates towards zero, see codegenDivision().
+  if (resultType == ValueType::I64) {
+    switch (node->op) {
+    case '+':
+      return builder->CreateAdd(leftExpr, rightExpr, "addtmp");
+    case '-':
+      return builder->CreateSub(leftExpr, rightExpr, "subtmp");
+    case '*':
+      return builder->CreateMul(leftExpr, rightExpr, "multmp");
+    case '/':
+      return this->codegenDivision(leftExpr, rightExpr);
+    default:
+      logsys::get()->error("Operation '{}' not supported", node->op);
+      return nullptr;
+    }
+  }
 
   switch (node->op) {
   case '+':
@@ -253,22 +546,146 @@ llvm::Value* Compiler::codegenBinaryOp(ASTNode* inputNode) {
   }
 }
 
+llvm::Value* Compiler::codegenDivision(llvm::Value* leftExpr, llvm::Value* rightExpr) {
+  // sdiv is undefined for a zero divisor and for the minimum value divided by -1. Dividing by zero
+  // gives 0 and dividing by -1 negates, wrapping around like the other integer operations.
+  llvm::Type* type = leftExpr->getType();
+  llvm::Value* isZero =
+      this->builder->CreateICmpEQ(rightExpr, llvm::ConstantInt::get(type, 0), "divzero");
+  llvm::Value* isMinusOne =
+      this->builder->CreateICmpEQ(rightExpr, llvm::ConstantInt::getSigned(type, -1), "divneg");
+
+  // The divisor of the sdiv is never 0 or -1, those cases take the value of the selects below.
+  llvm::Value* safeRight = this->builder->CreateSelect(
+      this->builder->CreateOr(isZero, isMinusOne), llvm::ConstantInt::get(type, 1), rightExpr);
+  llvm::Value* quotient = this->builder->CreateSDiv(leftExpr, safeRight, "divtmp");
+  llvm::Value* negated = this->builder->CreateSub(llvm::ConstantInt::get(type, 0), leftExpr);
+
+  llvm::Value* result = this->builder->CreateSelect(isMinusOne, negated, quotient);
+  return this->builder->CreateSelect(isZero, llvm::ConstantInt::get(type, 0), result, "divres");
+}
+
+llvm::Value* Compiler::codegenBuiltinCall(ASTNode* inputNode, std::vector<llvm::Value*> args) {
+  BuiltinCallNode* node = static_cast<BuiltinCallNode*>(inputNode);
+
+  const BuiltinInfo* builtin = findBuiltin(node->name);
+  if (!builtin || args.size() != builtin->arity) {
+    logsys::get()->error("Invalid call to function {}", node->name);
+    throw std::runtime_error("Invalid function call");
+  }
+
+  ValueType argumentsType = ValueType::Unknown;
+  for (llvm::Value* arg : args)
+    argumentsType = joinValueTypes(argumentsType, this->getValueTypeOf(arg));
+
+  // Convert all the arguments to the type the function works on.
+  llvm::Type* type = this->getLLVMType(getBuiltinResultType(*builtin, argumentsType));
+  for (llvm::Value*& arg : args)
+    arg = this->convertValue(arg, type);
+
+  if (type->isIntegerTy()) {
+    switch (builtin->id) {
+    case Builtin::Abs:
+      // abs of the minimum value wraps around like the other integer operations.
+      return this->builder->CreateIntrinsic(llvm::Intrinsic::abs, {type},
+                                            {args[0], this->builder->getFalse()});
+    case Builtin::Min:
+      return this->builder->CreateIntrinsic(llvm::Intrinsic::smin, {type}, args);
+    case Builtin::Max:
+      return this->builder->CreateIntrinsic(llvm::Intrinsic::smax, {type}, args);
+    case Builtin::Floor:
+      // Integers are already whole numbers.
+      return args[0];
+    default:
+      break;
+    }
+  }
+
+  llvm::Intrinsic::ID intrinsic;
+  switch (builtin->id) {
+  case Builtin::Sqrt:
+    intrinsic = llvm::Intrinsic::sqrt;
+    break;
+  case Builtin::Abs:
+    intrinsic = llvm::Intrinsic::fabs;
+    break;
+  case Builtin::Min:
+    intrinsic = llvm::Intrinsic::minnum;
+    break;
+  case Builtin::Max:
+    intrinsic = llvm::Intrinsic::maxnum;
+    break;
+  case Builtin::Fma:
+    intrinsic = llvm::Intrinsic::fma;
+    break;
+  case Builtin::Floor:
+    intrinsic = llvm::Intrinsic::floor;
+    break;
+  case Builtin::Exp:
+    intrinsic = llvm::Intrinsic::exp;
+    break;
+  case Builtin::Log:
+    intrinsic = llvm::Intrinsic::log;
+    break;
+  case Builtin::Pow:
+    intrinsic = llvm::Intrinsic::pow;
+    break;
+  case Builtin::Sin:
+    intrinsic = llvm::Intrinsic::sin;
+    break;
+  case Builtin::Cos:
+    intrinsic = llvm::Intrinsic::cos;
+    break;
+  }
+
+  return this->builder->CreateIntrinsic(intrinsic, {type}, args);
+}
+
 llvm::Value* Compiler::codegenAssignment(ASTNode* inputNode) {
   AssignmentNode* node = static_cast<AssignmentNode*>(inputNode);
 
-  // Get the global variable pointer.
-  llvm::Constant* variablePtr = this->getOrCreateGlobalVariable(node->name);
-
   // Parse the possible expression of the variable value.
   llvm::Value* variableValue = this->codegenExpr(node->value);
 
-  // Store the value in the variable.
-  builder->CreateStore(variableValue, variablePtr);
+  // Get the global variable pointer.
+  llvm::GlobalVariable* variablePtr = this->getOrCreateGlobalVariable(
+      node->name, this->getVariableLLVMType(node->name, variableValue->getType()));
+
+  // Store the value in the variable converted to the variable type.
+  builder->CreateStore(this->convertValue(variableValue, variablePtr->getValueType()),
+                       variablePtr);
+  this->invalidateValues(node->name);
 
   return variablePtr; // FIXME: a type of Value* should be returned and now is returning
                       // llvm::Constant*
 }
 
+llvm::Value* Compiler::codegenShow(ASTNode* inputNode) {
+  ShowNode* node = static_cast<ShowNode*>(inputNode);
+
+  llvm::Value* call = nullptr;
+  for (size_t i = 0; i < node->values.size(); i++) {
+    llvm::Value* value = this->codegenExpr(node->values[i]);
+
+    // Each value is followed by a space, the last one ends the line.
+    int32_t separator = i + 1 < node->values.size() ? ' ' : '\n';
+    call = this->builder->CreateCall(this->getShowFunction(value->getType()),
+                                     {value, this->builder->getInt32(separator)});
+  }
+
+  return call;
+}
+
+llvm::FunctionCallee Compiler::getShowFunction(llvm::Type* type) {
+  const char* name = type->isIntegerTy() ? "hebe_show_i64"
+                     : type->isFloatTy() ? "hebe_show_f32"
+                                         : "hebe_show_f64";
+
+  llvm::FunctionType* fnTy = llvm::FunctionType::get(
+      this->builder->getVoidTy(), {type, this->builder->getInt32Ty()}, false);
+  return this->module->getOrInsertFunction(name, fnTy);
+}
+
 llvm::Value* Compiler::codegenProcedureBody(ASTNode* inputNode) {
   ProcedureBodyNode* node = static_cast<ProcedureBodyNode*>(inputNode);
 
@@ -276,17 +693,23 @@ llvm::Value* Compiler::codegenProcedureBody(ASTNode* inputNode) {
   // FIXME: this has to be removed. I only put this for debugging because the IR optimization would
   // remove all expressions that had a result without being stored.
   llvm::AllocaInst* lastAlloca =
-      this->builder->CreateAlloca(llvm::Type::getFloatTy(*this->context), nullptr, "forDebug");
+      this->builder->CreateAlloca(llvm::Type::getDoubleTy(*this->context), nullptr, "forDebug");
 
   llvm::Value* expr = nullptr;
 
-  for (ASTNode* child : node->getItems()) {
+  std::vector<ASTNode*> items = node->getItems();
+  for (size_t i = 0; i < items.size(); i++) {
+    ASTNode* child = items[i];
+    this->emitDebugLocation(node->getLine(i));
     expr = this->codegenExpr(child);
 
     // FIXME: remove this, only for debugging. Storing instructions already stores desired
     // variables.
-    if (child->type == NodeType::Number || child->type == NodeType::BinaryOp)
-      this->builder->CreateStore(expr, lastAlloca);
+    if (child->type == NodeType::Number || child->type == NodeType::Integer ||
+        child->type == NodeType::Variable || child->type == NodeType::BinaryOp ||
+        child->type == NodeType::BuiltinCall)
+      this->builder->CreateStore(this->convertValue(expr, lastAlloca->getAllocatedType()),
+                                 lastAlloca);
   }
 
   return nullptr;
@@ -296,20 +719,47 @@ llvm::Value* Compiler::codegenProcedure(ASTNode* inputNode) {
 
   ProcedureNode* node = static_cast<ProcedureNode*>(inputNode);
 
+  auto imported = this->importedProcedures.find(node->name);
+  if (imported != this->importedProcedures.end()) {
+    logsys::get()->error("Procedure {} is already defined in library {}", node->name,
+                         imported->second);
+    throw std::runtime_error("Procedure already defined in an imported library");
+  }
+
   // Get the function type.
   llvm::FunctionType* fnTy = this->createFunctionType(llvm::Type::getVoidTy(*this->context));
 
   // Create the function.
   llvm::Function* fnPtr = this->createFunction(node->name, fnTy);
+  if (this->debugBuilder)
+    this->emitFunctionDebugInfo(fnPtr, node->line, this->getDebugFile(node->file));
+
+  // In tiered mode callers reach the procedure through its stub.
+  if (this->options.tiered)
+    this->emitProcedureStub(fnPtr);
 
   // Get a new basic block for the new function.
   llvm::BasicBlock* bbPtr = this->createBasicBlock("entry", node->name);
 
   // Save the basic block where the builder was inserting instructions to restore it later.
   llvm::BasicBlock* oldBbPtr = this->builder->GetInsertBlock();
+  llvm::DebugLoc oldDebugLoc = this->builder->getCurrentDebugLocation();
+
+  // Values of the parent function can not be used here.
+  std::unordered_map<ASTNode*, llvm::Value*> oldValueCache = std::move(this->valueCache);
+  std::unordered_map<std::string, std::vector<ASTNode*>> oldValueCacheReaders =
+      std::move(this->valueCacheReaders);
+  std::unordered_map<ASTNode*, std::vector<ASTNode*>> oldValueCacheDependents =
+      std::move(this->valueCacheDependents);
+  this->clearValueCache();
 
   // Set function insert point.
   this->builder->SetInsertPoint(bbPtr);
+  this->emitDebugLocation(node->line);
+
+  // Count procedure entries when generating a profile or deciding which procedures are hot.
+  if (!this->options.profileGenerate.empty() || this->options.tiered)
+    this->emitProfileCounter(node->name);
 
   // Parse the child instructions.
   this->codegenProcedureBody(node->body);
@@ -317,45 +767,237 @@ llvm::Value* Compiler::codegenProcedure(ASTNode* inputNode) {
   // Return void as the function is void type.
   this->builder->CreateRetVoid();
 
-  // Restore the old basic block to continue inserting instructions in the parent function.
-  this->builder->SetInsertPoint(oldBbPtr);
+  // Restore the old basic block to continue inserting instructions in the parent function. Library
+  // procedures have no parent function.
+  if (oldBbPtr)
+    this->builder->SetInsertPoint(oldBbPtr);
+  else
+    this->builder->ClearInsertionPoint();
+  this->builder->SetCurrentDebugLocation(oldDebugLoc);
+  this->valueCache = std::move(oldValueCache);
+  this->valueCacheReaders = std::move(oldValueCacheReaders);
+  this->valueCacheDependents = std::move(oldValueCacheDependents);
 
   return fnPtr;
 }
 
-llvm::Value* Compiler::codegenProcedureCall(ASTNode* inputNode) {
-  ProcedureCallNode* node = static_cast<ProcedureCallNode*>(inputNode);
-
+llvm::Value* Compiler::getProcedureAddress(const std::string& name) {
   // Get the procedure pointer to create a call instruction.
-  llvm::Function* procPtr = this->module->getFunction(node->name);
+  llvm::Function* procPtr = this->module->getFunction(name);
+
+  // Procedures of the imported libraries are declared on their first call.
+  if (!procPtr)
+    procPtr = this->declareImportedProcedure(name);
 
   if (!procPtr) {
-    logsys::get()->error("Function {} not found in llvm module", node->name);
+    logsys::get()->error("Function {} not found in llvm module", name);
     throw std::runtime_error("Function not found in llvm module");
   }
 
+  // In tiered mode load the current code address of the procedure. Library procedures have no
+  // stub, they are always called directly.
+  if (this->options.tiered && this->importedProcedures.count(name) == 0) {
+    llvm::GlobalVariable* stub = this->module->getGlobalVariable(procedureStubPrefix + name);
+    llvm::LoadInst* target =
+        this->builder->CreateLoad(this->builder->getPtrTy(), stub, name + ".target");
+    target->setAtomic(llvm::AtomicOrdering::Acquire);
+    return target;
+  }
+
+  return procPtr;
+}
+
+llvm::Value* Compiler::codegenProcedureCall(ASTNode* inputNode) {
+  ProcedureCallNode* node = static_cast<ProcedureCallNode*>(inputNode);
+
   // Call the procedure.
-  llvm::Value* retVal = this->builder->CreateCall(procPtr);
+  llvm::Value* retVal = this->builder->CreateCall(
+      this->createFunctionType(this->builder->getVoidTy()), this->getProcedureAddress(node->name));
+
+  // The procedure can assign any global.
+  this->clearValueCache();
 
   return retVal;
 }
 
+llvm::Value* Compiler::codegenParallel(ASTNode* inputNode) {
+  ParallelNode* node = static_cast<ParallelNode*>(inputNode);
+
+  llvm::Type* ptrTy = this->builder->getPtrTy();
+  llvm::FunctionCallee beginFn = this->module->getOrInsertFunction(
+      "hebe_parallel_begin", llvm::FunctionType::get(ptrTy, false));
+  llvm::FunctionCallee spawnFn = this->module->getOrInsertFunction(
+      "hebe_parallel_spawn",
+      llvm::FunctionType::get(this->builder->getVoidTy(), {ptrTy, ptrTy}, false));
+  llvm::FunctionCallee joinFn = this->module->getOrInsertFunction(
+      "hebe_parallel_join", llvm::FunctionType::get(this->builder->getVoidTy(), {ptrTy}, false));
+
+  // Every call of the block becomes a task of the same group, which is joined at the end.
+  llvm::Value* group = this->builder->CreateCall(beginFn, {}, "group");
+  for (ASTNode* item : static_cast<ProcedureBodyNode*>(node->body)->getItems()) {
+    if (item->type != NodeType::ProcedureCall) {
+      logsys::get()->error("Parallel blocks can only contain procedure calls");
+      throw std::runtime_error("Parallel blocks can only contain procedure calls");
+    }
+
+    llvm::Value* procedure =
+        this->getProcedureAddress(static_cast<ProcedureCallNode*>(item)->name);
+    this->builder->CreateCall(spawnFn, {group, procedure});
+  }
+
+  llvm::Value* join = this->builder->CreateCall(joinFn, {group});
+
+  // The procedures can assign any global.
+  this->clearValueCache();
+  return join;
+}
+
+llvm::Value* Compiler::codegenValue(ASTNode* rootNode) {
+  // Post-order walk with an explicit stack so that deep expressions do not overflow the call stack.
+  // A node is pushed twice: first to schedule its operands and then to combine their values, which
+  // are taken from the top of the value stack.
+  std::vector<std::pair<ASTNode*, bool>> pending{{rootNode, false}};
+  std::vector<llvm::Value*> values;
+
+  while (!pending.empty()) {
+    auto [node, operandsDone] = pending.back();
+
+    if (!operandsDone) {
+      // Shared expressions are generated once while their value is valid.
+      auto cached = node->references > 1 ? this->valueCache.find(node) : this->valueCache.end();
+      if (cached != this->valueCache.end()) {
+        values.push_back(cached->second);
+        pending.pop_back();
+        continue;
+      }
+
+      pending.back().second = true;
+      if (node->type == NodeType::BinaryOp) {
+        BinaryOpNode* binNode = static_cast<BinaryOpNode*>(node);
+        pending.emplace_back(binNode->right, false);
+        pending.emplace_back(binNode->left, false);
+      } else if (node->type == NodeType::BuiltinCall) {
+        std::vector<ASTNode*>& arguments = static_cast<BuiltinCallNode*>(node)->arguments;
+        for (auto it = arguments.rbegin(); it != arguments.rend(); ++it)
+          pending.emplace_back(*it, false);
+      }
+      continue;
+    }
+
+    pending.pop_back();
+
+    switch (node->type) {
+    case NodeType::Number:
+      values.push_back(this->codegenNumber(node));
+      break;
+    case NodeType::Integer:
+      values.push_back(this->codegenInteger(node));
+      break;
+    case NodeType::Variable:
+      values.push_back(this->codegenVariable(node));
+      break;
+    case NodeType::BinaryOp: {
+      llvm::Value* rightExpr = values.back();
+      values.pop_back();
+      llvm::Value* leftExpr = values.back();
+      values.back() = this->codegenBinaryOp(node, leftExpr, rightExpr);
+      break;
+    }
+    case NodeType::BuiltinCall: {
+      size_t count = static_cast<BuiltinCallNode*>(node)->arguments.size();
+      std::vector<llvm::Value*> args(values.end() - count, values.end());
+      values.resize(values.size() - count);
+      values.push_back(this->codegenBuiltinCall(node, std::move(args)));
+      break;
+    }
+    default:
+      logsys::get()->error("Code generation for type {} not supported.", getNodeType(node->type));
+      throw std::runtime_error("Code generation for this type of node not supported");
+    }
+
+    if (node->references > 1)
+      this->cacheValue(node, values.back());
+  }
+
+  return values.back();
+}
+
+void Compiler::cacheValue(ASTNode* node, llvm::Value* value) {
+  this->valueCache[node] = value;
+
+  // Index the expression by the globals it reads. Shared operands were cached before it and are
+  // already indexed, so the expression depends on them instead of walking their trees again. Each
+  // node is then walked once per generation of its nearest shared ancestor, which keeps caching
+  // linear in the size of the expression.
+  std::vector<ASTNode*> pending{node};
+  while (!pending.empty()) {
+    ASTNode* current = pending.back();
+    pending.pop_back();
+
+    if (current->type == NodeType::Variable) {
+      this->valueCacheReaders[static_cast<VariableNode*>(current)->name].push_back(node);
+    } else if (current != node && current->references > 1) {
+      this->valueCacheDependents[current].push_back(node);
+    } else if (current->type == NodeType::BinaryOp) {
+      pending.push_back(static_cast<BinaryOpNode*>(current)->left);
+      pending.push_back(static_cast<BinaryOpNode*>(current)->right);
+    } else if (current->type == NodeType::BuiltinCall) {
+      std::vector<ASTNode*>& arguments = static_cast<BuiltinCallNode*>(current)->arguments;
+      pending.insert(pending.end(), arguments.begin(), arguments.end());
+    }
+  }
+}
+
+void Compiler::invalidateValues(const std::string& name) {
+  auto it = this->valueCacheReaders.find(name);
+  if (it == this->valueCacheReaders.end())
+    return;
+
+  std::vector<ASTNode*> pending = std::move(it->second);
+  this->valueCacheReaders.erase(it);
+
+  // Expressions using a dropped value as an operand are dropped too.
+  while (!pending.empty()) {
+    ASTNode* node = pending.back();
+    pending.pop_back();
+    this->valueCache.erase(node);
+
+    auto dependents = this->valueCacheDependents.find(node);
+    if (dependents != this->valueCacheDependents.end()) {
+      pending.insert(pending.end(), dependents->second.begin(), dependents->second.end());
+      this->valueCacheDependents.erase(dependents);
+    }
+  }
+}
+
+void Compiler::clearValueCache() {
+  this->valueCache.clear();
+  this->valueCacheReaders.clear();
+  this->valueCacheDependents.clear();
+}
+
 llvm::Value* Compiler::codegenExpr(ASTNode* node) {
   if (!node)
     return nullptr;
   switch (node->type) {
   case NodeType::Number:
-    return this->codegenNumber(node);
+  case NodeType::Integer:
+  case NodeType::Variable:
   case NodeType::BinaryOp:
-    return this->codegenBinaryOp(node);
+  case NodeType::BuiltinCall:
+    return this->codegenValue(node);
   case NodeType::Assignment:
     return this->codegenAssignment(node);
+  case NodeType::Show:
+    return this->codegenShow(node);
   case NodeType::ProcedureBody:
     return this->codegenProcedureBody(node);
   case NodeType::Procedure:
     return this->codegenProcedure(node);
   case NodeType::ProcedureCall:
     return this->codegenProcedureCall(node);
+  case NodeType::Parallel:
+    return this->codegenParallel(node);
   default:
     logsys::get()->error("Code generation for type {} not supported.", getNodeType(node->type));
     throw std::runtime_error("Code generation for this type of node not supported");
@@ -363,7 +1005,8 @@ llvm::Value* Compiler::codegenExpr(ASTNode* node) {
 }
 
 void Compiler::generateCode() {
-  logsys::get()->info("Executing generateCode");
+  HEBE_TRACE_SCOPE("generateCode");
+  HEBE_LOG_DEBUG("Executing generateCode");
 
   // Ensure there is a list of nodes.
   if (!this->rootNode) {
@@ -371,50 +1014,498 @@ void Compiler::generateCode() {
     throw std::runtime_error("Failed to generate code.");
   }
 
-  // Create main function where the code will run.
-  llvm::FunctionType* mainFuncTy = this->createFunctionType(llvm::Type::getFloatTy(*this->context));
-  this->getOrCreateFunction("run", mainFuncTy);
+  this->importLibraries();
+
+  // Infer the types of all expressions and variables.
+  this->typeChecker.check(this->rootNode);
+  this->parallelChecker.check(this->rootNode);
+
+  this->beginRunFunction();
+
+  ProgramNode* program = static_cast<ProgramNode*>(this->rootNode);
+  std::vector<ASTNode*> items = program->getItems();
+  for (size_t i = 0; i < items.size(); i++)
+    this->codegenTopLevel(items[i], program->getLine(i));
+
+  this->finishRunFunction();
+}
+
+void Compiler::generateLibrary() {
+  HEBE_TRACE_SCOPE("generateLibrary");
+  HEBE_LOG_DEBUG("Executing generateLibrary");
+
+  if (!this->rootNode) {
+    logsys::get()->error("No code provided. rootNode is empty");
+    throw std::runtime_error("Failed to generate code.");
+  }
+
+  this->typeChecker.check(this->rootNode);
+  this->parallelChecker.check(this->rootNode);
+
+  // A library has no run function, so top level statements would never execute.
+  ProgramNode* program = static_cast<ProgramNode*>(this->rootNode);
+  for (ASTNode* node : program->getItems()) {
+    if (node->type != NodeType::Procedure) {
+      logsys::get()->error("Libraries can only contain procedure definitions, found {}",
+                           getNodeType(node->type));
+      throw std::runtime_error("Libraries can only contain procedure definitions");
+    }
+    if (static_cast<ProcedureNode*>(node)->name == "run") {
+      logsys::get()->error("Procedure run is the entry of programs and can not be in a library");
+      throw std::runtime_error("Procedure run can not be in a library");
+    }
+
+    this->codegenProcedure(node);
+  }
+
+  if (this->debugBuilder) {
+    this->debugBuilder->finalize();
+    this->debugBuilder.reset();
+    this->debugFiles.clear();
+  }
+}
+
+void Compiler::writeLibrary(const std::string& path) {
+  HEBE_TRACE_SCOPE("writeLibrary");
+
+  std::error_code EC;
+  llvm::raw_fd_ostream bitcode(path, EC, llvm::sys::fs::OF_None);
+  if (EC) {
+    logsys::get()->error("Could not open file {}: {}", path, EC.message());
+    throw std::runtime_error("Error writing library");
+  }
+  llvm::WriteBitcodeToFile(*this->module, bitcode);
+  bitcode.close();
+  if (bitcode.has_error()) {
+    logsys::get()->error("Could not write library {}: {}", path, bitcode.error().message());
+    bitcode.clear_error();
+    throw std::runtime_error("Error writing library");
+  }
+
+  // The index gives importers the types and accesses of the library without reading the bitcode.
+  LibraryIndex index;
+  for (const auto& [name, type] : this->typeChecker.getVariableTypes())
+    index.addGlobal(name, type);
+
+  for (ASTNode* node : static_cast<ProgramNode*>(this->rootNode)->getItems()) {
+    const std::string& name = static_cast<ProcedureNode*>(node)->name;
+    const ParallelChecker::Accesses* accesses = this->parallelChecker.getProcedureAccesses(name);
+
+    LibraryIndex::Procedure procedure;
+    procedure.name = name;
+    procedure.reads.assign(accesses->reads.begin(), accesses->reads.end());
+    procedure.writes.assign(accesses->writes.begin(), accesses->writes.end());
+    std::sort(procedure.reads.begin(), procedure.reads.end());
+    std::sort(procedure.writes.begin(), procedure.writes.end());
+    index.addProcedure(std::move(procedure));
+  }
+
+  index.writeToFile(path + libraryIndexSuffix);
+  logsys::get()->info("Wrote library {} with {} procedures", path, index.getProcedures().size());
+}
+
+void Compiler::importLibraries() {
+  for (const std::string& path : this->options.libraries) {
+    LibraryIndex index = LibraryIndex::readFromFile(path + libraryIndexSuffix);
+
+    // The generated code of the library fixes the type of its globals.
+    for (const auto& [name, type] : index.getGlobals()) {
+      auto [it, inserted] = this->importedGlobals.emplace(name, type);
+      if (!inserted && it->second != type) {
+        logsys::get()->error("Global {} has type {} in library {} and {} in another library", name,
+                             getValueType(type), path, getValueType(it->second));
+        throw std::runtime_error("Global has different types in the imported libraries");
+      }
+      this->typeChecker.declareVariable(name, type);
+    }
+
+    for (const LibraryIndex::Procedure& procedure : index.getProcedures()) {
+      auto [it, inserted] = this->importedProcedures.emplace(procedure.name, path);
+      if (!inserted) {
+        logsys::get()->error("Procedure {} is defined in libraries {} and {}", procedure.name,
+                             it->second, path);
+        throw std::runtime_error("Procedure defined in several imported libraries");
+      }
+
+      ParallelChecker::Accesses accesses;
+      accesses.reads.insert(procedure.reads.begin(), procedure.reads.end());
+      accesses.writes.insert(procedure.writes.begin(), procedure.writes.end());
+      this->parallelChecker.declareProcedure(procedure.name, std::move(accesses));
+    }
+  }
+}
+
+llvm::Function* Compiler::declareImportedProcedure(const std::string& name) {
+  auto it = this->importedProcedures.find(name);
+  if (it == this->importedProcedures.end())
+    return nullptr;
+
+  // The body is linked from the library once the program is complete.
+  this->usedLibraries.insert(it->second);
+  return this->createFunction(name, this->createFunctionType(this->builder->getVoidTy()));
+}
+
+void Compiler::linkLibraries() {
+  if (this->usedLibraries.empty())
+    return;
+
+  HEBE_TRACE_SCOPE("linkLibraries");
+
+  // The library code only declares the globals it uses, the program defines all of them.
+  for (const auto& [name, type] : this->importedGlobals)
+    this->getOrCreateGlobalVariable(name, this->getLLVMType(type));
+
+  for (const std::string& path : this->options.libraries) {
+    // Libraries without called procedures are never read.
+    if (this->usedLibraries.count(path) == 0)
+      continue;
+
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> buffer = llvm::MemoryBuffer::getFile(path);
+    if (!buffer) {
+      logsys::get()->error("Could not open library {}: {}", path, buffer.getError().message());
+      throw std::runtime_error("Error reading library");
+    }
+
+    // Only the module level records are parsed here. A function body is read when the linker
+    // materializes the function.
+    llvm::Expected<std::unique_ptr<llvm::Module>> library =
+        llvm::getOwningLazyBitcodeModule(std::move(*buffer), *this->context);
+    if (!library) {
+      llvm::consumeError(library.takeError());
+      logsys::get()->error("File {} is not a hebe library", path);
+      throw std::runtime_error("Invalid library");
+    }
+
+    // Programs get a target when they are optimized. Until then they take the one of the library.
+    if (this->module->getTargetTriple().empty()) {
+      this->module->setTargetTriple((*library)->getTargetTriple());
+      this->module->setDataLayout((*library)->getDataLayout());
+    }
+
+    // Only the procedures declared in the program, and the ones they call, are linked.
+    if (llvm::Linker::linkModules(*this->module, std::move(*library),
+                                  llvm::Linker::Flags::LinkOnlyNeeded)) {
+      logsys::get()->error("Could not link library {}", path);
+      throw std::runtime_error("Error linking library");
+    }
+  }
+
+  // The linker replaces the declarations with the definitions of the library.
+  for (const auto& [name, path] : this->importedProcedures) {
+    auto it = this->functionTable.find(name);
+    if (it != this->functionTable.end())
+      it->second = this->module->getFunction(name);
+  }
+}
+
+void Compiler::releaseAST() {
+  delete this->rootNode;
+  this->rootNode = nullptr;
+}
+
+void Compiler::releaseIR() {
+  this->builder.reset();
+  this->functionTable.clear();
+  this->basicBlockTable.clear();
+  this->globalVariableTable.clear();
+  this->runDebugAlloca = nullptr;
+  this->lastRunExpr = nullptr;
+  this->clearValueCache();
+}
+
+void Compiler::beginStreaming() {
+  HEBE_LOG_DEBUG("Executing streaming code generation");
+  this->importLibraries();
+  this->beginRunFunction();
+}
+
+void Compiler::streamItem(ASTNode* node, int line) {
+  // Types are inferred one item at a time, so variables keep the type of their first assignment.
+  this->typeChecker.checkItem(node);
+  this->parallelChecker.checkItem(node);
+  this->codegenTopLevel(node, line);
+
+  // The item is not needed anymore once its code exists. Its nodes can not be cached, their
+  // addresses will be reused.
+  this->clearValueCache();
+  delete node;
+}
+
+void Compiler::finishStreaming() { this->finishRunFunction(); }
+
+void Compiler::beginRunFunction() {
+  // Create main function where the code will run. It returns the value of "ret" as f64.
+  llvm::FunctionType* mainFuncTy =
+      this->createFunctionType(llvm::Type::getDoubleTy(*this->context));
+  llvm::Function* runFn = this->getOrCreateFunction("run", mainFuncTy);
+  this->emitFunctionDebugInfo(runFn, 1, this->debugFile);
 
   // Create the basic block that will be executed on program start.
   llvm::BasicBlock* entry = this->createBasicBlock("entry", "run");
   this->builder->SetInsertPoint(entry);
 
+  if (!this->options.profileGenerate.empty())
+    this->emitProfileCounter("run");
+
   // Create variable last alloca to avoid lose of instructions after optimization passes.
   // FIXME: this has to be removed. I only put this for debugging because the IR optimization would
   // remove all expressions that had a result without being stored.
-  llvm::AllocaInst* lastAlloca =
-      this->builder->CreateAlloca(llvm::Type::getFloatTy(*this->context), nullptr, "forDebug");
+  this->runDebugAlloca =
+      this->builder->CreateAlloca(llvm::Type::getDoubleTy(*this->context), nullptr, "forDebug");
 
-  llvm::Value* expr = nullptr;
+  this->lastRunExpr = nullptr;
+}
 
-  ProgramNode* program = static_cast<ProgramNode*>(this->rootNode);
-  for (ASTNode* node : program->getItems()) {
-    expr = this->codegenExpr(node);
+void Compiler::codegenTopLevel(ASTNode* node, int line) {
+  this->emitDebugLocation(line);
+  llvm::Value* expr = this->codegenExpr(node);
 
-    // FIXME: remove this, only for debugging. Storing instructions already stores desired
-    // variables.
-    if (node->type == NodeType::Number || node->type == NodeType::BinaryOp)
-      this->builder->CreateStore(expr, lastAlloca);
-  }
+  // FIXME: remove this, only for debugging. Storing instructions already stores desired
+  // variables.
+  if (node->type == NodeType::Number || node->type == NodeType::Integer ||
+      node->type == NodeType::Variable || node->type == NodeType::BinaryOp ||
+      node->type == NodeType::BuiltinCall)
+    this->builder->CreateStore(
+        this->convertValue(expr, this->runDebugAlloca->getAllocatedType()), this->runDebugAlloca);
+
+  this->lastRunExpr = expr;
+}
 
-  if (expr) {
-    llvm::Constant* retPtr = this->getOrCreateGlobalVariable("ret");
-    llvm::LoadInst* retValue =
-        this->builder->CreateLoad(llvm::Type::getFloatTy(*this->context), retPtr);
-    this->builder->CreateRet(retValue);
+void Compiler::finishRunFunction() {
+  if (this->lastRunExpr) {
+    llvm::GlobalVariable* retPtr = this->getOrCreateGlobalVariable(
+        "ret", this->getVariableLLVMType("ret", llvm::Type::getDoubleTy(*this->context)));
+    llvm::LoadInst* retValue = this->builder->CreateLoad(retPtr->getValueType(), retPtr);
+    this->builder->CreateRet(
+        this->convertValue(retValue, llvm::Type::getDoubleTy(*this->context)));
   } else {
     logsys::get()->error("Failed to generate code. Last evaluated expression has an error.");
     throw std::runtime_error("Failed to generate code. Last evaluated expression has an error.");
   }
+
+  // No more debug info is created once the code is complete.
+  if (this->debugBuilder) {
+    this->debugBuilder->finalize();
+    this->debugBuilder.reset();
+    this->debugFiles.clear();
+  }
+
+  this->linkLibraries();
+
+  // Annotate the functions with the execution counts of a previous run.
+  if (!this->options.profileUse.empty())
+    this->applyProfile();
+}
+
+void Compiler::optimize() {
+  HEBE_TRACE_SCOPE("optimize");
+
+  // Tiered mode starts from unoptimized code and optimizes hot procedures in the background.
+  if (this->options.tiered)
+    return;
+
+  if (this->options.optLevel == 0)
+    return;
+
+  // The vectorizers need the cost model of the host to turn math builtins into vector code.
+  llvm::InitializeNativeTarget();
+  auto jtmbExpected = llvm::orc::JITTargetMachineBuilder::detectHost();
+  if (!jtmbExpected) {
+    llvm::consumeError(jtmbExpected.takeError());
+    logsys::get()->error("Failed to detect host target");
+    throw std::runtime_error("Failed to detect host target");
+  }
+  if (this->getFastMathFlags().allowContract())
+    jtmbExpected->getOptions().AllowFPOpFusion = llvm::FPOpFusion::Fast;
+  auto tmExpected = jtmbExpected->createTargetMachine();
+  if (!tmExpected) {
+    llvm::consumeError(tmExpected.takeError());
+    logsys::get()->error("Failed to create target machine");
+    throw std::runtime_error("Failed to create target machine");
+  }
+  std::unique_ptr<llvm::TargetMachine> targetMachine = std::move(*tmExpected);
+  this->module->setTargetTriple(targetMachine->getTargetTriple());
+  this->module->setDataLayout(targetMachine->createDataLayout());
+
+  optimizeModule(*this->module, this->options.optLevel, targetMachine.get(),
+                 this->options.vectorLibrary);
+}
+
+llvm::Error Compiler::defineRuntimeSymbols(llvm::orc::LLJIT& jit) {
+  llvm::orc::MangleAndInterner mangle(jit.getExecutionSession(), jit.getDataLayout());
+  llvm::orc::SymbolMap symbols;
+
+  auto addSymbol = [&](const char* name, auto* function) {
+    symbols[mangle(name)] = {llvm::orc::ExecutorAddr::fromPtr(function),
+                             llvm::JITSymbolFlags::Exported | llvm::JITSymbolFlags::Callable};
+  };
+  addSymbol("hebe_show_i64", &hebe_show_i64);
+  addSymbol("hebe_show_f32", &hebe_show_f32);
+  addSymbol("hebe_show_f64", &hebe_show_f64);
+  addSymbol("hebe_show_flush", &hebe_show_flush);
+  addSymbol("hebe_parallel_begin", &hebe_parallel_begin);
+  addSymbol("hebe_parallel_spawn", &hebe_parallel_spawn);
+  addSymbol("hebe_parallel_join", &hebe_parallel_join);
+
+  return jit.getMainJITDylib().define(llvm::orc::absoluteSymbols(std::move(symbols)));
+}
+
+std::unique_ptr<StateFile> Compiler::openState() {
+  HEBE_TRACE_SCOPE("openState");
+
+  // Every variable of the program, the globals of the compiler itself are not saved.
+  std::vector<StateFile::Variable> variables;
+  for (const auto& [name, global] : this->globalVariableTable) {
+    llvm::Type* type = global->getValueType();
+    variables.push_back({name, type->isIntegerTy() ? ValueType::I64
+                               : type->isFloatTy() ? ValueType::F32
+                                                   : ValueType::F64});
+  }
+
+  auto state = std::make_unique<StateFile>(this->options.stateFile, variables);
+  HEBE_LOG_DEBUG("State {} loaded at generation {}", this->options.stateFile,
+                 state->getGeneration());
+  return state;
+}
+
+llvm::Error Compiler::defineStateSymbols(llvm::orc::LLJIT& jit, const StateFile& state) {
+  llvm::orc::MangleAndInterner mangle(jit.getExecutionSession(), jit.getDataLayout());
+  llvm::orc::SymbolMap symbols;
+
+  for (const auto& [name, global] : this->globalVariableTable)
+    symbols[mangle(name)] = {llvm::orc::ExecutorAddr::fromPtr(state.getSlot(name)),
+                             llvm::JITSymbolFlags::Exported};
+
+  return jit.getMainJITDylib().define(llvm::orc::absoluteSymbols(std::move(symbols)));
+}
+
+void Compiler::emitProfileCounter(const std::string& functionName) {
+  llvm::Type* counterTy = llvm::Type::getInt64Ty(*this->context);
+
+  // The counter is external so that it can be looked up in the JIT after the run.
+  llvm::GlobalVariable* counter = new llvm::GlobalVariable(
+      *this->module, counterTy, false, llvm::GlobalValue::ExternalLinkage,
+      llvm::ConstantInt::get(counterTy, 0), profileCounterPrefix + functionName);
+
+  // Atomic increment so that counts stay exact if procedures run concurrently.
+  this->builder->CreateAtomicRMW(llvm::AtomicRMWInst::Add, counter,
+                                 llvm::ConstantInt::get(counterTy, 1), llvm::MaybeAlign(8),
+                                 llvm::AtomicOrdering::Monotonic);
+
+  this->profiledFunctions.push_back(functionName);
+}
+
+void Compiler::emitProcedureStub(llvm::Function* function) {
+  // The stub starts pointing to the unoptimized code and is swapped by the TieredJIT.
+  new llvm::GlobalVariable(*this->module, this->builder->getPtrTy(), false,
+                           llvm::GlobalValue::ExternalLinkage, function,
+                           procedureStubPrefix + function->getName().str());
+}
+
+void Compiler::applyProfile() {
+  Profile profile = Profile::readFromFile(this->options.profileUse);
+  uint64_t hotCount = std::max<uint64_t>(profile.getMaxCount() / hotCountDivisor, 1);
+
+  for (auto& [name, function] : this->functionTable) {
+    // Functions that did not exist when the profile was recorded keep the default heuristics.
+    if (!profile.contains(name))
+      continue;
+
+    uint64_t count = profile.getCount(name);
+    function->setEntryCount(count);
+
+    // Hot procedures are good inlining candidates, never executed ones are moved out of the way.
+    if (count >= hotCount) {
+      function->addFnAttr(llvm::Attribute::Hot);
+      function->addFnAttr(llvm::Attribute::InlineHint);
+    } else if (count == 0) {
+      function->addFnAttr(llvm::Attribute::Cold);
+      function->addFnAttr(llvm::Attribute::MinSize);
+      function->addFnAttr(llvm::Attribute::OptimizeForSize);
+    }
+  }
+
+  logsys::get()->info("Applied profile {} to {} functions", this->options.profileUse,
+                      profile.size());
+}
+
+void Compiler::writeProfile(llvm::orc::LLJIT& jit) {
+  Profile profile;
+
+  for (const std::string& name : this->profiledFunctions) {
+    auto counterExpected = jit.lookup(profileCounterPrefix + name);
+    if (!counterExpected) {
+      llvm::consumeError(counterExpected.takeError());
+      logsys::get()->error("Profile counter of {} not found in JIT", name);
+      throw std::runtime_error("Profile counter not found in JIT");
+    }
+
+    profile.setCount(name, *counterExpected->toPtr<uint64_t*>());
+  }
+
+  profile.writeToFile(this->options.profileGenerate);
 }
 
 int Compiler::runJIT() {
+  std::optional<tracing::Scope> setupScope(std::in_place, "jitSetup");
+
   // Init LLVM JIT target.
   llvm::InitializeNativeTarget();
   llvm::InitializeNativeTargetAsmPrinter();
 
+  llvm::orc::LLJITBuilder jitBuilder;
+
+  // Tiered mode generates the first version of the code as fast as possible. With contraction
+  // the backend also fuses the multiplications and additions it creates itself.
+  bool allowContract = this->getFastMathFlags().allowContract();
+  if (this->options.tiered || allowContract) {
+    auto jtmbExpected = llvm::orc::JITTargetMachineBuilder::detectHost();
+    if (!jtmbExpected) {
+      llvm::errs() << "Failed to detect host target\n";
+      return 1;
+    }
+    if (this->options.tiered)
+      jtmbExpected->setCodeGenOptLevel(llvm::CodeGenOptLevel::None);
+    if (allowContract)
+      jtmbExpected->getOptions().AllowFPOpFusion = llvm::FPOpFusion::Fast;
+    jitBuilder.setJITTargetMachineBuilder(std::move(*jtmbExpected));
+  }
+
+  if (this->options.lowMemory)
+    logResidentMemory("before JIT");
+
+  // Listeners registering the generated code with profilers and debuggers.
+  std::unique_ptr<PerfMapListener> perfMapListener;
+  std::vector<llvm::JITEventListener*> listeners;
+  if (this->options.gdb)
+    listeners.push_back(llvm::JITEventListener::createGDBRegistrationListener());
+  if (this->options.perf) {
+    perfMapListener = std::make_unique<PerfMapListener>();
+    listeners.push_back(perfMapListener.get());
+    logsys::get()->info("Writing perf map to {}", perfMapListener->getPath());
+
+    // jitdump files with line tables, only available when LLVM is built with perf support.
+    if (llvm::JITEventListener* jitdumpListener =
+            llvm::JITEventListener::createPerfJITEventListener())
+      listeners.push_back(jitdumpListener);
+    else
+      logsys::get()->warn("LLVM is built without perf support, no jitdump file is written");
+  }
+
+  if (!listeners.empty()) {
+    if (this->options.lowMemory)
+      logsys::get()->warn("The compact JIT memory is not used when registering with perf or GDB");
+    jitBuilder.setObjectLinkingLayerCreator([listeners](llvm::orc::ExecutionSession& ES) {
+      return createListenedObjectLayer(ES, listeners);
+    });
+  } else if (this->options.lowMemory) {
+    // Place the code and data of every module next to each other in one reserved region instead
+    // of mapping separate pages for each allocation.
+    jitBuilder.setObjectLinkingLayerCreator(createCompactObjectLayer);
+  }
+
   // Create the JIT.
-  auto jitExpected = llvm::orc::LLJITBuilder().create();
+  auto jitExpected = jitBuilder.create();
   if (!jitExpected) {
     llvm::errs() << "Failed to create LLJIT\n";
     return 1;
@@ -430,6 +1521,50 @@ int Compiler::runJIT() {
   }
   J->getMainJITDylib().addGenerator(std::move(*genExpected));
 
+  // Functions of the hebe runtime called by the generated code.
+  if (auto err = this->defineRuntimeSymbols(*J)) {
+    llvm::consumeError(std::move(err));
+    llvm::errs() << "Failed to define runtime symbols\n";
+    return 1;
+  }
+
+  // Globals live in the mapped state file instead of the JIT memory.
+  std::unique_ptr<StateFile> state;
+  if (!this->options.stateFile.empty()) {
+    try {
+      state = this->openState();
+    } catch (const std::runtime_error&) {
+      return 1;
+    }
+    if (auto err = this->defineStateSymbols(*J, *state)) {
+      llvm::consumeError(std::move(err));
+      llvm::errs() << "Failed to define state symbols\n";
+      return 1;
+    }
+  }
+
+  // Vector math functions are resolved from the selected library.
+  if (!this->options.vectorLibrary.empty()) {
+    std::string error;
+    const char* path = getVectorLibraryPath(this->options.vectorLibrary);
+    if (llvm::sys::DynamicLibrary::LoadLibraryPermanently(path, &error))
+      logsys::get()->warn("Could not load vector library {}: {}", path, error);
+  }
+
+  // Keep a copy of the unoptimized module to recompile hot procedures from it.
+  std::unique_ptr<TieredJIT> tieredJIT;
+  if (this->options.tiered) {
+    std::vector<std::string> procedures;
+    for (const std::string& name : this->profiledFunctions)
+      if (name != "run")
+        procedures.push_back(name);
+
+    tieredJIT = std::make_unique<TieredJIT>(*J, *this->module, std::move(procedures),
+                                            this->options.tierUpThreshold,
+                                            !this->options.profileGenerate.empty(),
+                                            allowContract, this->options.vectorLibrary);
+  }
+
   // Put your Module into a ThreadSafeModule and add it to the JIT.
   llvm::orc::ThreadSafeModule TSM(std::move(this->module), std::move(this->context));
   if (auto err = J->addIRModule(std::move(TSM))) {
@@ -445,10 +1580,48 @@ int Compiler::runJIT() {
   }
 
   // Call it like a normal C function.
-  using RunFn = float (*)();
+  using RunFn = double (*)();
   auto addr = symExpected->getValue();
   auto runFn = reinterpret_cast<RunFn>(addr);
-  float result = runFn();
+
+  // The whole module is compiled now, so the JIT has already freed the IR and its context.
+  if (this->options.lowMemory) {
+    this->releaseIR();
+    trimHeap();
+    logResidentMemory("after releasing IR");
+  }
+  setupScope.reset();
+
+  if (tieredJIT)
+    tieredJIT->start();
+
+  configureParallelRuntime(this->options.threads);
+
+  double result;
+  {
+    HEBE_TRACE_SCOPE("execute");
+    result = runFn();
+    hebe_show_flush();
+  }
+
+  if (tieredJIT) {
+    tieredJIT->stop();
+    HEBE_LOG_DEBUG("{} procedures promoted to optimized code", tieredJIT->getPromotedCount());
+  }
+
+  // Dump the counters of the instrumented run.
+  if (!this->options.profileGenerate.empty())
+    this->writeProfile(*J);
+
+  // Save the globals for the next run.
+  if (state && !this->options.stateReadOnly) {
+    HEBE_TRACE_SCOPE("checkpoint");
+    try {
+      state->checkpoint();
+    } catch (const std::runtime_error&) {
+      return 1;
+    }
+  }
 
   return static_cast<int>(result);
 }
\ No newline at end of file
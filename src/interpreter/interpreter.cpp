@@ -0,0 +1,567 @@
+#include "interpreter/interpreter.h"
+
+#include <cmath>
+#include <exception>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+
+#include "logging.h"
+#include "runtime/parallel.h"
+#include "runtime/show.h"
+#include "semantic/builtins.h"
+#include "tracing.h"
+
+namespace {
+// Name of the global returned by the program.
+const std::string resultGlobal = "ret";
+// Nested calls allowed before giving up. Generated code would overflow the stack instead.
+constexpr size_t maxCallDepth = 1 << 20;
+
+uint64_t addCost(uint64_t a, uint64_t b) {
+  return a > std::numeric_limits<uint64_t>::max() - b ? std::numeric_limits<uint64_t>::max()
+                                                      : a + b;
+}
+
+// Integer operations wrap around like the LLVM instructions without nsw/nuw flags.
+int64_t wrap(uint64_t value) { return static_cast<int64_t>(value); }
+
+// Integer division as in the generated code: x / 0 is 0 and the minimum value / -1 wraps around.
+int64_t divide(int64_t left, int64_t right) {
+  if (right == 0)
+    return 0;
+  if (right == -1)
+    return wrap(0 - static_cast<uint64_t>(left));
+  return left / right;
+}
+
+// Floating point to integer as llvm.fptosi.sat in the generated code: NaN is 0 and values out of
+// range are clamped. static_cast is undefined for them.
+int64_t saturate(double value) {
+  // -2^63 and 2^63 are exact doubles.
+  constexpr double limit = 9223372036854775808.0;
+  if (std::isnan(value))
+    return 0;
+  if (value >= limit)
+    return std::numeric_limits<int64_t>::max();
+  if (value < -limit)
+    return std::numeric_limits<int64_t>::min();
+  return static_cast<int64_t>(value);
+}
+
+size_t getOperandCount(ASTNode* node) {
+  if (node->type == NodeType::BinaryOp)
+    return 2;
+  if (node->type == NodeType::BuiltinCall)
+    return static_cast<BuiltinCallNode*>(node)->arguments.size();
+  return 0;
+}
+
+ASTNode* getOperand(ASTNode* node, size_t index) {
+  if (node->type == NodeType::BinaryOp) {
+    BinaryOpNode* binNode = static_cast<BinaryOpNode*>(node);
+    return index == 0 ? binNode->left : binNode->right;
+  }
+  return static_cast<BuiltinCallNode*>(node)->arguments[index];
+}
+} // namespace
+
+Interpreter::Interpreter(ASTNode* rootNode, CompilerOptions options)
+    : rootNode(rootNode), options(std::move(options)) {}
+
+void Interpreter::compile() {
+  HEBE_TRACE_SCOPE("compileBytecode");
+
+  if (!this->rootNode) {
+    logsys::get()->error("No code provided. rootNode is empty");
+    throw std::runtime_error("Failed to generate code.");
+  }
+
+  this->typeChecker.check(this->rootNode);
+  this->parallelChecker.check(this->rootNode);
+
+  this->procedures.assign(1, Procedure());
+  this->procedures[0].name = "run";
+  this->procedureTable = {{"run", 0}};
+  this->parallelBlocks.clear();
+  this->globals.clear();
+  this->globalTable.clear();
+
+  std::vector<ASTNode*> items = static_cast<ProgramNode*>(this->rootNode)->getItems();
+  if (items.empty()) {
+    logsys::get()->error("Failed to generate code. Last evaluated expression has an error.");
+    throw std::runtime_error("Failed to generate code. Last evaluated expression has an error.");
+  }
+
+  for (ASTNode* item : items)
+    this->compileStatement(item, 0);
+  this->finishProcedure(0);
+}
+
+uint64_t Interpreter::getEstimatedCost() const {
+  return this->procedures.empty() ? 0 : this->procedures[0].cost;
+}
+
+void Interpreter::emit(uint32_t procedure, OpCode code, uint32_t operand, Value value) {
+  // Nested procedures are added while their parent is compiled, so the code is not kept by
+  // reference.
+  this->procedures[procedure].code.push_back({code, operand, value});
+}
+
+void Interpreter::compileStatement(ASTNode* node, uint32_t procedure) {
+  switch (node->type) {
+  case NodeType::Assignment: {
+    AssignmentNode* assignNode = static_cast<AssignmentNode*>(node);
+    this->compileValue(assignNode->value, procedure);
+
+    uint32_t global = this->getOrCreateGlobal(assignNode->name);
+    this->emitConversion(procedure, assignNode->value->valueType, this->globals[global].type);
+    this->emit(procedure, OpCode::Store, global);
+    break;
+  }
+  case NodeType::Show: {
+    std::vector<ASTNode*>& values = static_cast<ShowNode*>(node)->values;
+    for (size_t i = 0; i < values.size(); i++) {
+      this->compileValue(values[i], procedure);
+
+      // Each value is followed by a space, the last one ends the line.
+      uint32_t separator = i + 1 < values.size() ? ' ' : '\n';
+      OpCode code = values[i]->valueType == ValueType::I64   ? OpCode::ShowI64
+                    : values[i]->valueType == ValueType::F32 ? OpCode::ShowF32
+                                                             : OpCode::ShowF64;
+      this->emit(procedure, code, separator);
+    }
+    break;
+  }
+  case NodeType::Procedure:
+    this->compileProcedure(node);
+    break;
+  case NodeType::ProcedureCall:
+    this->emit(procedure, OpCode::Call,
+               this->getProcedureIndex(static_cast<ProcedureCallNode*>(node)->name));
+    break;
+  case NodeType::Parallel: {
+    std::vector<uint32_t> calls;
+    for (ASTNode* item : static_cast<ProcedureBodyNode*>(static_cast<ParallelNode*>(node)->body)
+                             ->getItems()) {
+      if (item->type != NodeType::ProcedureCall) {
+        logsys::get()->error("Parallel blocks can only contain procedure calls");
+        throw std::runtime_error("Parallel blocks can only contain procedure calls");
+      }
+      calls.push_back(this->getProcedureIndex(static_cast<ProcedureCallNode*>(item)->name));
+    }
+
+    this->parallelBlocks.push_back(std::move(calls));
+    this->emit(procedure, OpCode::Parallel, this->parallelBlocks.size() - 1);
+    break;
+  }
+  case NodeType::Number:
+  case NodeType::Integer:
+  case NodeType::Variable:
+  case NodeType::BinaryOp:
+  case NodeType::BuiltinCall:
+    // Expression lines are evaluated and their value dropped.
+    this->compileValue(node, procedure);
+    this->emit(procedure, OpCode::Pop);
+    break;
+  default:
+    logsys::get()->error("Code generation for type {} not supported.", getNodeType(node->type));
+    throw std::runtime_error("Code generation for this type of node not supported");
+  }
+}
+
+void Interpreter::compileProcedure(ASTNode* inputNode) {
+  ProcedureNode* node = static_cast<ProcedureNode*>(inputNode);
+
+  if (this->procedureTable.count(node->name)) {
+    logsys::get()->error("Function {} already exists and can not be created", node->name);
+    throw std::runtime_error("Function already exists and can not be created");
+  }
+
+  // The procedure exists from its definition on, so it can call itself.
+  uint32_t procedure = this->procedures.size();
+  this->procedures.emplace_back();
+  this->procedures[procedure].name = node->name;
+  this->procedureTable[node->name] = procedure;
+
+  for (ASTNode* item : static_cast<ProcedureBodyNode*>(node->body)->getItems())
+    this->compileStatement(item, procedure);
+  this->finishProcedure(procedure);
+}
+
+void Interpreter::finishProcedure(uint32_t procedure) {
+  this->emit(procedure, OpCode::Return);
+
+  // Every instruction counts once plus the cost of the procedures it runs. Calls to procedures
+  // that are still being compiled are recursive.
+  uint64_t cost = this->procedures[procedure].code.size();
+  auto addCall = [&](uint32_t callee) {
+    const Procedure& calleeProcedure = this->procedures[callee];
+    cost = addCost(cost, calleeProcedure.compiled ? calleeProcedure.cost
+                                                  : std::numeric_limits<uint64_t>::max());
+  };
+
+  for (const Instruction& instruction : this->procedures[procedure].code) {
+    if (instruction.code == OpCode::Call)
+      addCall(instruction.operand);
+    else if (instruction.code == OpCode::Parallel)
+      for (uint32_t callee : this->parallelBlocks[instruction.operand])
+        addCall(callee);
+  }
+
+  this->procedures[procedure].cost = cost;
+  this->procedures[procedure].compiled = true;
+}
+
+void Interpreter::compileValue(ASTNode* rootNode, uint32_t procedure) {
+  // Post-order walk with an explicit stack. Each node is paired with the number of operands
+  // already scheduled, and every time the walk comes back to it the last operand is converted to
+  // the type of the operation.
+  std::vector<std::pair<ASTNode*, size_t>> pending{{rootNode, 0}};
+
+  while (!pending.empty()) {
+    auto [node, scheduled] = pending.back();
+    size_t operandCount = getOperandCount(node);
+
+    if (scheduled > 0)
+      this->emitConversion(procedure, getOperand(node, scheduled - 1)->valueType, node->valueType);
+
+    if (scheduled < operandCount) {
+      pending.back().second++;
+      pending.emplace_back(getOperand(node, scheduled), 0);
+      continue;
+    }
+
+    pending.pop_back();
+
+    switch (node->type) {
+    case NodeType::Number: {
+      Value value;
+      if (node->valueType == ValueType::F32)
+        value.f32 = static_cast<float>(static_cast<NumberNode*>(node)->value);
+      else
+        value.f64 = static_cast<NumberNode*>(node)->value;
+      this->emit(procedure, OpCode::Constant, 0, value);
+      break;
+    }
+    case NodeType::Integer: {
+      Value value;
+      value.i64 = static_cast<IntegerNode*>(node)->value;
+      this->emit(procedure, OpCode::Constant, 0, value);
+      break;
+    }
+    case NodeType::Variable:
+      this->emit(procedure, OpCode::Load,
+                 this->getOrCreateGlobal(static_cast<VariableNode*>(node)->name));
+      break;
+    case NodeType::BinaryOp: {
+      // Operations of each type are consecutive in OpCode, in the order +, -, *, /.
+      OpCode first = node->valueType == ValueType::I64   ? OpCode::AddI64
+                     : node->valueType == ValueType::F32 ? OpCode::AddF32
+                                                         : OpCode::AddF64;
+      size_t offset;
+      switch (static_cast<BinaryOpNode*>(node)->op) {
+      case '+':
+        offset = 0;
+        break;
+      case '-':
+        offset = 1;
+        break;
+      case '*':
+        offset = 2;
+        break;
+      case '/':
+        offset = 3;
+        break;
+      default:
+        logsys::get()->error("Operation '{}' not supported", static_cast<BinaryOpNode*>(node)->op);
+        throw std::runtime_error("Operation not supported");
+      }
+      this->emit(procedure, static_cast<OpCode>(static_cast<size_t>(first) + offset));
+      break;
+    }
+    case NodeType::BuiltinCall: {
+      const BuiltinInfo* builtin = findBuiltin(static_cast<BuiltinCallNode*>(node)->name);
+      // Integers are already whole numbers.
+      if (node->valueType == ValueType::I64 && builtin->id == Builtin::Floor)
+        break;
+
+      OpCode code = node->valueType == ValueType::I64   ? OpCode::BuiltinI64
+                    : node->valueType == ValueType::F32 ? OpCode::BuiltinF32
+                                                        : OpCode::BuiltinF64;
+      this->emit(procedure, code, static_cast<uint32_t>(builtin->id));
+      break;
+    }
+    default:
+      logsys::get()->error("Code generation for type {} not supported.", getNodeType(node->type));
+      throw std::runtime_error("Code generation for this type of node not supported");
+    }
+  }
+}
+
+void Interpreter::emitConversion(uint32_t procedure, ValueType from, ValueType to) {
+  if (from == to)
+    return;
+
+  OpCode code;
+  if (from == ValueType::I64)
+    code = to == ValueType::F32 ? OpCode::I64ToF32 : OpCode::I64ToF64;
+  else if (to == ValueType::I64)
+    code = from == ValueType::F32 ? OpCode::F32ToI64 : OpCode::F64ToI64;
+  else
+    code = to == ValueType::F64 ? OpCode::F32ToF64 : OpCode::F64ToF32;
+
+  this->emit(procedure, code);
+}
+
+uint32_t Interpreter::getProcedureIndex(const std::string& name) const {
+  auto it = this->procedureTable.find(name);
+  if (it == this->procedureTable.end()) {
+    logsys::get()->error("Function {} not found in llvm module", name);
+    throw std::runtime_error("Function not found in llvm module");
+  }
+  return it->second;
+}
+
+uint32_t Interpreter::getOrCreateGlobal(const std::string& name) {
+  auto it = this->globalTable.find(name);
+  if (it != this->globalTable.end())
+    return it->second;
+
+  // Globals start at zero, as the ones of the generated code.
+  Global global;
+  global.type = this->typeChecker.getVariableType(name);
+  global.value.i64 = 0;
+
+  this->globals.push_back(global);
+  this->globalTable[name] = this->globals.size() - 1;
+  return this->globals.size() - 1;
+}
+
+double Interpreter::getGlobal(const std::string& name) const {
+  auto it = this->globalTable.find(name);
+  if (it == this->globalTable.end())
+    return 0.0;
+
+  const Global& global = this->globals[it->second];
+  switch (global.type) {
+  case ValueType::I64:
+    return static_cast<double>(global.value.i64);
+  case ValueType::F32:
+    return static_cast<double>(global.value.f32);
+  default:
+    return global.value.f64;
+  }
+}
+
+double Interpreter::execute() {
+  HEBE_TRACE_SCOPE("execute");
+
+  this->executeProcedure(0);
+  return this->getGlobal(resultGlobal);
+}
+
+int Interpreter::run() {
+  configureParallelRuntime(this->options.threads);
+
+  double result = this->execute();
+  hebe_show_flush();
+
+  return static_cast<int>(result);
+}
+
+void Interpreter::executeProcedure(uint32_t procedure) {
+  std::vector<Value> stack;
+  // Instruction to continue with when each active call returns.
+  std::vector<const Instruction*> frames;
+  const Instruction* ip = this->procedures[procedure].code.data();
+
+  while (true) {
+    const Instruction& instruction = *ip++;
+
+    switch (instruction.code) {
+    case OpCode::Constant:
+      stack.push_back(instruction.value);
+      break;
+    case OpCode::Load:
+      stack.push_back(this->globals[instruction.operand].value);
+      break;
+    case OpCode::Store:
+      this->globals[instruction.operand].value = stack.back();
+      stack.pop_back();
+      break;
+    case OpCode::Pop:
+      stack.pop_back();
+      break;
+
+    case OpCode::I64ToF32:
+      stack.back().f32 = static_cast<float>(stack.back().i64);
+      break;
+    case OpCode::I64ToF64:
+      stack.back().f64 = static_cast<double>(stack.back().i64);
+      break;
+    case OpCode::F32ToI64:
+      stack.back().i64 = saturate(stack.back().f32);
+      break;
+    case OpCode::F64ToI64:
+      stack.back().i64 = saturate(stack.back().f64);
+      break;
+    case OpCode::F32ToF64:
+      stack.back().f64 = static_cast<double>(stack.back().f32);
+      break;
+    case OpCode::F64ToF32:
+      stack.back().f32 = static_cast<float>(stack.back().f64);
+      break;
+
+#define HEBE_BINARY_OP(CODE, FIELD, EXPRESSION)                                                    \
+  case OpCode::CODE: {                                                                             \
+    auto right = stack.back().FIELD;                                                               \
+    stack.pop_back();                                                                              \
+    auto left = stack.back().FIELD;                                                                \
+    stack.back().FIELD = (EXPRESSION);                                                             \
+    break;                                                                                         \
+  }
+      HEBE_BINARY_OP(AddI64, i64, wrap(static_cast<uint64_t>(left) + static_cast<uint64_t>(right)))
+      HEBE_BINARY_OP(SubI64, i64, wrap(static_cast<uint64_t>(left) - static_cast<uint64_t>(right)))
+      HEBE_BINARY_OP(MulI64, i64, wrap(static_cast<uint64_t>(left) * static_cast<uint64_t>(right)))
+      HEBE_BINARY_OP(DivI64, i64, divide(left, right))
+      HEBE_BINARY_OP(AddF32, f32, left + right)
+      HEBE_BINARY_OP(SubF32, f32, left - right)
+      HEBE_BINARY_OP(MulF32, f32, left * right)
+      HEBE_BINARY_OP(DivF32, f32, left / right)
+      HEBE_BINARY_OP(AddF64, f64, left + right)
+      HEBE_BINARY_OP(SubF64, f64, left - right)
+      HEBE_BINARY_OP(MulF64, f64, left * right)
+      HEBE_BINARY_OP(DivF64, f64, left / right)
+#undef HEBE_BINARY_OP
+
+    case OpCode::BuiltinI64: {
+      int64_t& top = stack.back().i64;
+      switch (static_cast<Builtin>(instruction.operand)) {
+      case Builtin::Abs:
+        // abs of the minimum value wraps around like the other integer operations.
+        top = top < 0 ? wrap(0 - static_cast<uint64_t>(top)) : top;
+        break;
+      case Builtin::Min:
+      case Builtin::Max: {
+        int64_t right = top;
+        stack.pop_back();
+        int64_t& left = stack.back().i64;
+        left = static_cast<Builtin>(instruction.operand) == Builtin::Min ? std::min(left, right)
+                                                                          : std::max(left, right);
+        break;
+      }
+      default:
+        break;
+      }
+      break;
+    }
+
+#define HEBE_BUILTIN_OP(CODE, FIELD, TYPE)                                                         \
+  case OpCode::CODE: {                                                                             \
+    Builtin builtin = static_cast<Builtin>(instruction.operand);                                   \
+    if (builtin == Builtin::Fma) {                                                                 \
+      TYPE addend = stack.back().FIELD;                                                            \
+      stack.pop_back();                                                                            \
+      TYPE factor = stack.back().FIELD;                                                            \
+      stack.pop_back();                                                                            \
+      stack.back().FIELD = std::fma(stack.back().FIELD, factor, addend);                           \
+      break;                                                                                       \
+    }                                                                                              \
+    if (builtin == Builtin::Min || builtin == Builtin::Max || builtin == Builtin::Pow) {           \
+      TYPE right = stack.back().FIELD;                                                             \
+      stack.pop_back();                                                                            \
+      TYPE& left = stack.back().FIELD;                                                             \
+      left = builtin == Builtin::Min   ? std::fmin(left, right)                                    \
+             : builtin == Builtin::Max ? std::fmax(left, right)                                    \
+                                       : std::pow(left, right);                                    \
+      break;                                                                                       \
+    }                                                                                              \
+    TYPE& top = stack.back().FIELD;                                                                \
+    switch (builtin) {                                                                             \
+    case Builtin::Sqrt:                                                                            \
+      top = std::sqrt(top);                                                                        \
+      break;                                                                                       \
+    case Builtin::Abs:                                                                             \
+      top = std::fabs(top);                                                                        \
+      break;                                                                                       \
+    case Builtin::Floor:                                                                           \
+      top = std::floor(top);                                                                       \
+      break;                                                                                       \
+    case Builtin::Exp:                                                                             \
+      top = std::exp(top);                                                                         \
+      break;                                                                                       \
+    case Builtin::Log:                                                                             \
+      top = std::log(top);                                                                         \
+      break;                                                                                       \
+    case Builtin::Sin:                                                                             \
+      top = std::sin(top);                                                                         \
+      break;                                                                                       \
+    case Builtin::Cos:                                                                             \
+      top = std::cos(top);                                                                         \
+      break;                                                                                       \
+    default:                                                                                       \
+      break;                                                                                       \
+    }                                                                                              \
+    break;                                                                                         \
+  }
+      // The float overloads call the same libm functions (sinf, powf, ...) as the f32 intrinsics.
+      HEBE_BUILTIN_OP(BuiltinF32, f32, float)
+      HEBE_BUILTIN_OP(BuiltinF64, f64, double)
+#undef HEBE_BUILTIN_OP
+
+    case OpCode::ShowI64:
+      hebe_show_i64(stack.back().i64, static_cast<int32_t>(instruction.operand));
+      stack.pop_back();
+      break;
+    case OpCode::ShowF32:
+      hebe_show_f32(stack.back().f32, static_cast<int32_t>(instruction.operand));
+      stack.pop_back();
+      break;
+    case OpCode::ShowF64:
+      hebe_show_f64(stack.back().f64, static_cast<int32_t>(instruction.operand));
+      stack.pop_back();
+      break;
+
+    case OpCode::Call:
+      if (frames.size() >= maxCallDepth) {
+        logsys::get()->error("Procedure {} exceeded the maximum call depth",
+                             this->procedures[instruction.operand].name);
+        throw std::runtime_error("Maximum call depth exceeded");
+      }
+      frames.push_back(ip);
+      ip = this->procedures[instruction.operand].code.data();
+      break;
+    case OpCode::Parallel: {
+      // The parallel checker guarantees that the procedures of a block do not share globals
+      // they write, so they can update the globals without locks.
+      // An exception leaving a pool thread terminates the program, so the first error of the
+      // tasks is kept and rethrown once all of them end.
+      std::mutex errorMutex;
+      std::exception_ptr error;
+      void* group = hebe_parallel_begin();
+      for (uint32_t callee : this->parallelBlocks[instruction.operand])
+        spawnParallelTask(group, [this, callee, &errorMutex, &error] {
+          try {
+            this->executeProcedure(callee);
+          } catch (...) {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (!error)
+              error = std::current_exception();
+          }
+        });
+      hebe_parallel_join(group);
+      if (error)
+        std::rethrow_exception(error);
+      break;
+    }
+    case OpCode::Return:
+      if (frames.empty())
+        return;
+      ip = frames.back();
+      frames.pop_back();
+      break;
+    }
+  }
+}
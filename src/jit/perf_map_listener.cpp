@@ -0,0 +1,61 @@
+#include "jit/perf_map_listener.h"
+
+#include <cstdio>
+#include <llvm/Object/SymbolSize.h>
+#include <unistd.h>
+#include <utility>
+
+#include "logging.h"
+
+PerfMapListener::PerfMapListener(std::string path) : path(std::move(path)) {
+  if (this->path.empty())
+    this->path = "/tmp/perf-" + std::to_string(getpid()) + ".map";
+}
+
+std::string PerfMapListener::formatEntry(uint64_t address, uint64_t size,
+                                         const std::string& name) {
+  char range[48];
+  std::snprintf(range, sizeof(range), "%llx %llx ", static_cast<unsigned long long>(address),
+                static_cast<unsigned long long>(size));
+  return range + name + "\n";
+}
+
+void PerfMapListener::notifyObjectLoaded(ObjectKey key, const llvm::object::ObjectFile& object,
+                                         const llvm::RuntimeDyld::LoadedObjectInfo& loadedInfo) {
+  // The debug copy of the object has its sections at the addresses where they were loaded.
+  llvm::object::OwningBinary<llvm::object::ObjectFile> debugObject =
+      loadedInfo.getObjectForDebug(object);
+  if (!debugObject.getBinary())
+    return;
+
+  std::string entries;
+  for (const auto& [symbol, size] : llvm::object::computeSymbolSizes(*debugObject.getBinary())) {
+    llvm::Expected<llvm::object::SymbolRef::Type> type = symbol.getType();
+    if (!type || *type != llvm::object::SymbolRef::ST_Function) {
+      llvm::consumeError(type.takeError());
+      continue;
+    }
+
+    llvm::Expected<llvm::StringRef> name = symbol.getName();
+    llvm::Expected<uint64_t> address = symbol.getAddress();
+    if (!name || !address) {
+      llvm::consumeError(name.takeError());
+      llvm::consumeError(address.takeError());
+      continue;
+    }
+
+    entries += formatEntry(*address, size, name->str());
+  }
+
+  std::lock_guard<std::mutex> lock(this->mutex);
+  if (!this->file.is_open()) {
+    this->file.open(this->path, std::ios::app);
+    if (!this->file) {
+      logsys::get()->warn("Could not open perf map {}", this->path);
+      return;
+    }
+  }
+
+  // perf may read the map while the program runs.
+  this->file << entries << std::flush;
+}
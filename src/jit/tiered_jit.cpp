@@ -0,0 +1,181 @@
+#include "jit/tiered_jit.h"
+
+#include <chrono>
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/ExecutionEngine/Orc/CompileUtils.h>
+#include <llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/raw_ostream.h>
+#include <stdexcept>
+#include <utility>
+
+#include "compiler.h"
+#include "logging.h"
+#include "optimizer.h"
+#include "tracing.h"
+
+namespace {
+// Time between two reads of the procedure counters.
+constexpr std::chrono::milliseconds pollInterval(1);
+// Suffix of the symbol holding the optimized version of a procedure.
+const std::string optimizedSuffix = ".tier2";
+} // namespace
+
+TieredJIT::TieredJIT(llvm::orc::LLJIT& jit, const llvm::Module& module,
+                     std::vector<std::string> procedures, uint64_t threshold,
+                     bool keepCounters, bool fuseFPOperations, std::string vectorLibrary)
+    : jit(jit), threshold(threshold), keepCounters(keepCounters),
+      fuseFPOperations(fuseFPOperations), vectorLibrary(std::move(vectorLibrary)) {
+  llvm::raw_svector_ostream stream(this->bitcode);
+  llvm::WriteBitcodeToFile(module, stream);
+
+  for (std::string& name : procedures)
+    this->procedures.push_back({std::move(name)});
+}
+
+void TieredJIT::start() {
+  // Resolve the counter and stub of every procedure.
+  for (Procedure& procedure : this->procedures) {
+    auto counterExpected = this->jit.lookup(profileCounterPrefix + procedure.name);
+    auto stubExpected = this->jit.lookup(procedureStubPrefix + procedure.name);
+    if (!counterExpected || !stubExpected) {
+      llvm::consumeError(counterExpected.takeError());
+      llvm::consumeError(stubExpected.takeError());
+      logsys::get()->error("Tier globals of procedure {} not found in JIT", procedure.name);
+      throw std::runtime_error("Tier globals not found in JIT");
+    }
+    procedure.counter = counterExpected->toPtr<uint64_t*>();
+    procedure.stub = stubExpected->toPtr<void**>();
+  }
+
+  // Optimized code uses the most aggressive code generation of the host.
+  auto jtmbExpected = llvm::orc::JITTargetMachineBuilder::detectHost();
+  if (!jtmbExpected) {
+    llvm::consumeError(jtmbExpected.takeError());
+    logsys::get()->error("Failed to detect host for tiered compilation");
+    throw std::runtime_error("Failed to detect host for tiered compilation");
+  }
+  jtmbExpected->setCodeGenOptLevel(llvm::CodeGenOptLevel::Aggressive);
+  if (this->fuseFPOperations)
+    jtmbExpected->getOptions().AllowFPOpFusion = llvm::FPOpFusion::Fast;
+
+  auto tmExpected = jtmbExpected->createTargetMachine();
+  if (!tmExpected) {
+    llvm::consumeError(tmExpected.takeError());
+    logsys::get()->error("Failed to create target machine for tiered compilation");
+    throw std::runtime_error("Failed to create target machine for tiered compilation");
+  }
+  this->targetMachine = std::move(*tmExpected);
+
+  this->worker = std::thread(&TieredJIT::watchCounters, this);
+}
+
+void TieredJIT::stop() {
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->stopRequested = true;
+  }
+  this->wakeUp.notify_all();
+
+  if (this->worker.joinable())
+    this->worker.join();
+}
+
+void TieredJIT::watchCounters() {
+  std::unique_lock<std::mutex> lock(this->mutex);
+
+  while (!this->wakeUp.wait_for(lock, pollInterval, [this] { return this->stopRequested; })) {
+    for (Procedure& procedure : this->procedures) {
+      if (procedure.promoted || __atomic_load_n(procedure.counter, __ATOMIC_RELAXED) < threshold)
+        continue;
+
+      // A failed promotion keeps running the unoptimized code, so it is not retried.
+      procedure.promoted = true;
+      if (this->promote(procedure))
+        this->promotedCount++;
+    }
+  }
+}
+
+bool TieredJIT::promote(Procedure& procedure) {
+  HEBE_TRACE_SCOPE("tierUp");
+
+  auto context = std::make_unique<llvm::LLVMContext>();
+
+  llvm::MemoryBufferRef buffer(llvm::StringRef(this->bitcode.data(), this->bitcode.size()),
+                               "tier1");
+  auto moduleExpected = llvm::parseBitcodeFile(buffer, *context);
+  if (!moduleExpected) {
+    llvm::consumeError(moduleExpected.takeError());
+    logsys::get()->error("Failed to parse bitcode for procedure {}", procedure.name);
+    return false;
+  }
+  std::unique_ptr<llvm::Module> module = std::move(*moduleExpected);
+
+  // Every global already lives in the JIT, so only declarations are kept.
+  for (llvm::GlobalVariable& global : module->globals()) {
+    global.setInitializer(nullptr);
+    global.setLinkage(llvm::GlobalValue::ExternalLinkage);
+  }
+
+  // Keep only the body of the promoted procedure, under a new name.
+  llvm::Function* function = nullptr;
+  for (llvm::Function& candidate : *module) {
+    if (candidate.getName() == procedure.name)
+      function = &candidate;
+    else if (!candidate.isDeclaration())
+      candidate.deleteBody();
+  }
+  if (!function) {
+    logsys::get()->error("Procedure {} not found in bitcode", procedure.name);
+    return false;
+  }
+  function->setName(procedure.name + optimizedSuffix);
+
+  // The optimized code no longer needs to count its calls, unless the counts go to a profile.
+  if (!this->keepCounters) {
+    llvm::GlobalVariable* counter =
+        module->getGlobalVariable(profileCounterPrefix + procedure.name);
+    std::vector<llvm::Instruction*> increments;
+    for (llvm::User* user : counter->users())
+      if (auto* increment = llvm::dyn_cast<llvm::AtomicRMWInst>(user))
+        if (increment->getFunction() == function)
+          increments.push_back(increment);
+    for (llvm::Instruction* increment : increments)
+      increment->eraseFromParent();
+  }
+
+  module->setDataLayout(this->targetMachine->createDataLayout());
+  module->setTargetTriple(this->targetMachine->getTargetTriple());
+  optimizeModule(*module, 3, this->targetMachine.get(), this->vectorLibrary);
+
+  // Compile to an object file and add it to the running JIT.
+  llvm::orc::SimpleCompiler compile(*this->targetMachine);
+  auto objectExpected = compile(*module);
+  if (!objectExpected) {
+    llvm::consumeError(objectExpected.takeError());
+    logsys::get()->error("Failed to compile optimized procedure {}", procedure.name);
+    return false;
+  }
+
+  if (auto err = this->jit.addObjectFile(std::move(*objectExpected))) {
+    llvm::consumeError(std::move(err));
+    logsys::get()->error("Failed to add optimized procedure {} to JIT", procedure.name);
+    return false;
+  }
+
+  auto symExpected = this->jit.lookup(procedure.name + optimizedSuffix);
+  if (!symExpected) {
+    llvm::consumeError(symExpected.takeError());
+    logsys::get()->error("Optimized procedure {} not found in JIT", procedure.name);
+    return false;
+  }
+
+  // Publish the optimized code. Callers load the stub with acquire ordering.
+  __atomic_store_n(procedure.stub, symExpected->toPtr<void*>(), __ATOMIC_RELEASE);
+
+  HEBE_LOG_DEBUG("Procedure {} promoted to optimized code", procedure.name);
+  return true;
+}
@@ -0,0 +1,344 @@
+#include "lexer/lexer.h"
+
+#include <cerrno>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+#include <system_error>
+#include <unistd.h>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "lexer/identifier_table.h"
+#include "logging.h"
+
+namespace {
+
+// Byte classes of scanner.l: whitespace is [ \t\r] and words are [0-9a-zA-Z_\-\>], except for
+// their first byte, which is not a digit.
+struct CharacterClasses {
+  bool space[256] = {};
+  bool word[256] = {};
+
+  constexpr CharacterClasses() {
+    space[static_cast<unsigned char>(' ')] = true;
+    space[static_cast<unsigned char>('\t')] = true;
+    space[static_cast<unsigned char>('\r')] = true;
+
+    for (int c = '0'; c <= '9'; c++)
+      word[c] = true;
+    for (int c = 'a'; c <= 'z'; c++)
+      word[c] = word[c - 'a' + 'A'] = true;
+    word[static_cast<unsigned char>('_')] = true;
+    word[static_cast<unsigned char>('-')] = true;
+    word[static_cast<unsigned char>('>')] = true;
+  }
+};
+
+constexpr CharacterClasses classes;
+
+bool isSpace(char c) { return classes.space[static_cast<unsigned char>(c)]; }
+bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+#if defined(__SSE2__)
+__m128i equals(__m128i chars, char c) { return _mm_cmpeq_epi8(chars, _mm_set1_epi8(c)); }
+
+// Bytes above 0x7f are negative and never match.
+__m128i inRange(__m128i chars, char low, char high) {
+  return _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8(static_cast<char>(low - 1))),
+                       _mm_cmplt_epi8(chars, _mm_set1_epi8(static_cast<char>(high + 1))));
+}
+
+// Offset of the first byte of the block that is not selected, 16 if all of them are.
+unsigned firstUnselected(__m128i selected) {
+  unsigned other = ~static_cast<unsigned>(_mm_movemask_epi8(selected)) & 0xffffu;
+  return other ? __builtin_ctz(other) : 16;
+}
+
+unsigned spaceLength(const char* text) {
+  __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text));
+  return firstUnselected(_mm_or_si128(_mm_or_si128(equals(chars, ' '), equals(chars, '\t')),
+                                      equals(chars, '\r')));
+}
+
+unsigned wordLength(const char* text) {
+  __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text));
+  // Setting bit 5 turns upper case letters into lower case ones and keeps the rest out of [a, z].
+  __m128i lower = _mm_or_si128(chars, _mm_set1_epi8(0x20));
+  __m128i word = _mm_or_si128(inRange(chars, '0', '9'), inRange(lower, 'a', 'z'));
+  word = _mm_or_si128(word, _mm_or_si128(equals(chars, '_'), equals(chars, '-')));
+  return firstUnselected(_mm_or_si128(word, equals(chars, '>')));
+}
+#define HEBE_LEXER_SIMD
+#elif defined(__ARM_NEON)
+uint8x16_t equals(uint8x16_t chars, char c) {
+  return vceqq_u8(chars, vdupq_n_u8(static_cast<uint8_t>(c)));
+}
+
+uint8x16_t inRange(uint8x16_t chars, char low, char high) {
+  return vcleq_u8(vsubq_u8(chars, vdupq_n_u8(static_cast<uint8_t>(low))),
+                  vdupq_n_u8(static_cast<uint8_t>(high - low)));
+}
+
+// Offset of the first byte of the block that is not selected, 16 if all of them are. Each byte of
+// the comparison is narrowed to a nibble of a 64 bit mask.
+unsigned firstUnselected(uint8x16_t selected) {
+  uint8x8_t nibbles = vshrn_n_u16(vreinterpretq_u16_u8(selected), 4);
+  uint64_t other = ~vget_lane_u64(vreinterpret_u64_u8(nibbles), 0);
+  return other ? __builtin_ctzll(other) / 4 : 16;
+}
+
+unsigned spaceLength(const char* text) {
+  uint8x16_t chars = vld1q_u8(reinterpret_cast<const uint8_t*>(text));
+  return firstUnselected(
+      vorrq_u8(vorrq_u8(equals(chars, ' '), equals(chars, '\t')), equals(chars, '\r')));
+}
+
+unsigned wordLength(const char* text) {
+  uint8x16_t chars = vld1q_u8(reinterpret_cast<const uint8_t*>(text));
+  uint8x16_t lower = vorrq_u8(chars, vdupq_n_u8(0x20));
+  uint8x16_t word = vorrq_u8(inRange(chars, '0', '9'), inRange(lower, 'a', 'z'));
+  word = vorrq_u8(word, vorrq_u8(equals(chars, '_'), equals(chars, '-')));
+  return firstUnselected(vorrq_u8(word, equals(chars, '>')));
+}
+#define HEBE_LEXER_SIMD
+#endif
+
+#ifdef HEBE_LEXER_SIMD
+// Position of the first byte not selected by scan, reading 16 bytes at a time. The text ends with
+// a NUL byte followed by padding, and NUL is never selected.
+template <unsigned (*scan)(const char*)> const char* skipWhile(const char* cursor) {
+  unsigned length;
+  while ((length = scan(cursor)) == 16)
+    cursor += 16;
+  return cursor + length;
+}
+
+const char* skipSpaces(const char* cursor) {
+  // Most tokens are separated by a single space or none at all.
+  if (!isSpace(cursor[0]))
+    return cursor;
+  if (!isSpace(cursor[1]))
+    return cursor + 1;
+  return skipWhile<spaceLength>(cursor + 2);
+}
+
+const char* skipWord(const char* cursor) { return skipWhile<wordLength>(cursor); }
+#else
+bool isWord(char c) { return classes.word[static_cast<unsigned char>(c)]; }
+
+const char* skipSpaces(const char* cursor) {
+  while (isSpace(*cursor))
+    cursor++;
+  return cursor;
+}
+
+const char* skipWord(const char* cursor) {
+  while (isWord(*cursor))
+    cursor++;
+  return cursor;
+}
+#endif
+
+const char* skipDigits(const char* cursor) {
+  while (isDigit(*cursor))
+    cursor++;
+  return cursor;
+}
+
+// Longest match of the number rules of scanner.l, (\-)?[0-9]+ followed by an optional \.[0-9]+
+// and, after it, an optional [fF]. Returns begin if there is no number.
+const char* scanNumber(const char* begin, TokenKind& kind) {
+  const char* cursor = begin + (*begin == '-');
+  const char* integerEnd = skipDigits(cursor);
+  if (integerEnd == cursor)
+    return begin;
+
+  kind = TokenKind::Integer;
+  if (integerEnd[0] != '.' || !isDigit(integerEnd[1]))
+    return integerEnd;
+
+  kind = TokenKind::Number;
+  const char* fractionEnd = skipDigits(integerEnd + 1);
+  if (*fractionEnd != 'f' && *fractionEnd != 'F')
+    return fractionEnd;
+
+  kind = TokenKind::FNumber;
+  return fractionEnd + 1;
+}
+
+// Returns false if the integer is out of the range of 64 bits, as strtoll does in Flex.
+bool parseInteger(const char* begin, const char* end, long long& value) {
+  return std::from_chars(begin, end, value).ec != std::errc::result_out_of_range;
+}
+
+// std::from_chars is exact and does not depend on the locale. Values out of the range of a double
+// are rare and left to strtod, which rounds them to infinity or zero like atof.
+double parseDouble(const char* begin, const char* end) {
+  double value = 0.0;
+  if (std::from_chars(begin, end, value).ec == std::errc::result_out_of_range)
+    return std::strtod(std::string(begin, end).c_str(), nullptr);
+  return value;
+}
+
+// Keywords of scanner.l. They only match a whole word, longer words win in Flex.
+TokenKind keywordOrWord(std::string_view text) {
+  switch (text.size()) {
+  case 2:
+    if (text == "in")
+      return TokenKind::In;
+    if (text == "->")
+      return TokenKind::Arrow;
+    break;
+  case 4:
+    if (text == "save")
+      return TokenKind::Save;
+    if (text == "done")
+      return TokenKind::Done;
+    if (text == "show")
+      return TokenKind::Show;
+    break;
+  case 6:
+    if (text == "create")
+      return TokenKind::Create;
+    break;
+  case 8:
+    if (text == "parallel")
+      return TokenKind::Parallel;
+    break;
+  }
+  return TokenKind::Word;
+}
+
+} // namespace
+
+Lexer::Lexer(std::string text) { this->setText(std::move(text)); }
+
+Lexer::Lexer(FILE* input) : input(input) { this->setText(std::string()); }
+
+void Lexer::setText(std::string text) {
+  size_t size = text.size();
+  this->text = std::move(text);
+  this->text.append(paddingSize, '\0');
+  this->cursor = this->text.data();
+  this->end = this->cursor + size;
+}
+
+bool Lexer::refill() {
+  if (!this->input)
+    return false;
+
+  // read() returns what is available instead of waiting for a whole chunk like fread().
+  std::string text = std::move(this->pending);
+  this->pending.clear();
+  size_t lineEnd = std::string::npos;
+  char chunk[chunkSize];
+  while (lineEnd == std::string::npos) {
+    ssize_t size = read(fileno(this->input), chunk, sizeof(chunk));
+    if (size < 0 && errno == EINTR)
+      continue;
+    if (size <= 0) {
+      // The last line may not end with a newline.
+      this->input = nullptr;
+      break;
+    }
+
+    size_t newline = std::string_view(chunk, static_cast<size_t>(size)).rfind('\n');
+    if (newline != std::string_view::npos)
+      lineEnd = text.size() + newline + 1;
+    text.append(chunk, static_cast<size_t>(size));
+  }
+
+  if (lineEnd != std::string::npos) {
+    this->pending.assign(text, lineEnd, std::string::npos);
+    text.resize(lineEnd);
+  }
+  if (text.empty())
+    return false;
+
+  this->setText(std::move(text));
+  return true;
+}
+
+Token Lexer::next() {
+  const char* begin = skipSpaces(this->cursor);
+
+  // Tokens end before the newline, so a token is never split between two buffers.
+  while (begin >= this->end && this->refill())
+    begin = skipSpaces(this->cursor);
+
+  Token token;
+  token.line = this->line;
+
+  if (begin >= this->end) {
+    this->cursor = this->end;
+    token.kind = TokenKind::End;
+    return token;
+  }
+
+  bool followsNumber = this->afterNumber && begin == this->cursor;
+  this->afterNumber = false;
+
+  if (*begin == '\n') {
+    token.line = ++this->line;
+    token.kind = TokenKind::Newline;
+    this->cursor = begin + 1;
+    return token;
+  }
+
+  // A '-' between digits, as in 10-3, is the operator and not the sign of the next number.
+  if (followsNumber && begin[0] == '-' && isDigit(begin[1])) {
+    token.kind = TokenKind::Char;
+    token.character = '-';
+    this->cursor = begin + 1;
+    return token;
+  }
+
+  // Flex picks the longest match and, between matches of the same length, the first rule. Numbers
+  // come before words and both may start with '-'.
+  const char* wordEnd = isDigit(*begin) ? begin : skipWord(begin);
+  TokenKind numberKind = TokenKind::End;
+  const char* numberEnd = scanNumber(begin, numberKind);
+
+  if (numberEnd > begin && numberEnd >= wordEnd) {
+    token.kind = numberKind;
+    if (numberKind != TokenKind::Integer) {
+      token.number = parseDouble(begin, numberEnd - (numberKind == TokenKind::FNumber));
+    } else if (!parseInteger(begin, numberEnd, token.integer)) {
+      logsys::get()->error("Integer {} in line {} is out of range",
+                           std::string_view(begin, numberEnd - begin), this->line);
+      token.kind = TokenKind::Error;
+    }
+    this->afterNumber = token.kind != TokenKind::Error;
+    this->cursor = numberEnd;
+    return token;
+  }
+
+  if (wordEnd > begin) {
+    std::string_view text(begin, wordEnd - begin);
+    this->cursor = wordEnd;
+
+    // A lone '-' is the operator rule, which comes before words.
+    if (text == "-") {
+      token.kind = TokenKind::Char;
+      token.character = '-';
+      return token;
+    }
+
+    token.kind = keywordOrWord(text);
+    if (token.kind == TokenKind::Word)
+      token.word = internIdentifier(text);
+    return token;
+  }
+
+  token.kind = TokenKind::Char;
+  token.character = *begin;
+  this->cursor = begin + 1;
+  return token;
+}
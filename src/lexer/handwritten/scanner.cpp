@@ -0,0 +1,90 @@
+// Interface of the Flex generated scanner on top of the hand-written Lexer. Only linked when the
+// build selects the hand-written lexer (HEBE_LEXER=handwritten).
+
+#include <cstdio>
+#include <string>
+#include <utility>
+
+#include "lexer/lexer.h"
+#include "parser.hpp"
+
+struct yy_buffer_state {
+  Lexer lexer;
+
+  explicit yy_buffer_state(std::string text) : lexer(std::move(text)) {}
+  explicit yy_buffer_state(FILE* input) : lexer(input) {}
+};
+
+typedef yy_buffer_state* YY_BUFFER_STATE;
+
+FILE* yyin = nullptr;
+int yylineno = 1;
+
+namespace {
+YY_BUFFER_STATE currentBuffer = nullptr;
+} // namespace
+
+YY_BUFFER_STATE yy_scan_string(const char* str) {
+  // As in Flex, the new buffer becomes the current one.
+  currentBuffer = new yy_buffer_state(str);
+  return currentBuffer;
+}
+
+void yy_switch_to_buffer(YY_BUFFER_STATE new_buffer) { currentBuffer = new_buffer; }
+
+void yy_delete_buffer(YY_BUFFER_STATE buffer) {
+  if (buffer == currentBuffer)
+    currentBuffer = nullptr;
+  delete buffer;
+}
+
+int yylex() {
+  // Without a buffer the input file is read as it is lexed.
+  if (!currentBuffer)
+    currentBuffer = new yy_buffer_state(yyin ? yyin : stdin);
+
+  Lexer& lexer = currentBuffer->lexer;
+  lexer.setLine(yylineno);
+  Token token = lexer.next();
+  yylineno = lexer.getLine();
+  yylloc.first_line = yylloc.last_line = token.line;
+
+  switch (token.kind) {
+  case TokenKind::End:
+    return 0;
+  case TokenKind::Save:
+    return SAVE;
+  case TokenKind::In:
+    return IN;
+  case TokenKind::Create:
+    return CREATE;
+  case TokenKind::Done:
+    return DONE;
+  case TokenKind::Show:
+    return SHOW;
+  case TokenKind::Parallel:
+    return PARALLEL;
+  case TokenKind::Number:
+    yylval.fval = token.number;
+    return NUMBER;
+  case TokenKind::FNumber:
+    yylval.fval = token.number;
+    return FNUMBER;
+  case TokenKind::Integer:
+    yylval.ival = token.integer;
+    return INTEGER;
+  case TokenKind::Word:
+    yylval.sval = token.word;
+    return WORD;
+  case TokenKind::Arrow:
+    return ARROW;
+  case TokenKind::Newline:
+    return NEWLINE;
+  case TokenKind::Char:
+    return static_cast<unsigned char>(token.character);
+  case TokenKind::Error:
+    // The parser stops without reporting it again.
+    return YYerror;
+  }
+  return 0;
+}
@@ -0,0 +1,56 @@
+#include "lexer/identifier_table.h"
+
+#include <cstring>
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+// Identifiers are copied into blocks of this size instead of being allocated one by one.
+constexpr size_t blockSize = 64 * 1024;
+
+class IdentifierTable {
+public:
+  const char* intern(std::string_view identifier) {
+    auto it = this->identifiers.find(identifier);
+    if (it != this->identifiers.end())
+      return it->data();
+
+    char* copy = this->allocate(identifier.size() + 1);
+    std::memcpy(copy, identifier.data(), identifier.size());
+    copy[identifier.size()] = '\0';
+
+    this->identifiers.insert(std::string_view(copy, identifier.size()));
+    return copy;
+  }
+
+private:
+  // Views point into the blocks, which are never moved or freed while the table exists.
+  std::unordered_set<std::string_view> identifiers;
+  std::vector<std::unique_ptr<char[]>> blocks;
+  size_t blockUsed = blockSize;
+
+  char* allocate(size_t size) {
+    // Identifiers longer than a block get a block of their own.
+    if (size > blockSize) {
+      this->blocks.insert(this->blocks.begin(), std::make_unique<char[]>(size));
+      return this->blocks.front().get();
+    }
+
+    if (this->blockUsed + size > blockSize) {
+      this->blocks.push_back(std::make_unique<char[]>(blockSize));
+      this->blockUsed = 0;
+    }
+
+    char* memory = this->blocks.back().get() + this->blockUsed;
+    this->blockUsed += size;
+    return memory;
+  }
+};
+} // namespace
+
+const char* internIdentifier(std::string_view identifier) {
+  // The streaming parser runs in its own thread, so every thread has its own table.
+  thread_local IdentifierTable table;
+  return table.intern(identifier);
+}
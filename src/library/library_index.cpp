@@ -0,0 +1,120 @@
+#include "library/library_index.h"
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+#include "logging.h"
+
+namespace {
+// First line of every index file. Changing the format requires changing the version.
+const std::string libraryIndexHeader = "# hebe library v1";
+
+// Reads "<count> <name>..." from an index line.
+bool readNames(std::istringstream& fields, std::vector<std::string>& names) {
+  size_t count;
+  if (!(fields >> count))
+    return false;
+
+  // The names are read one by one, a corrupted count can not allocate more than the line holds.
+  std::string name;
+  for (size_t i = 0; i < count; i++) {
+    if (!(fields >> name))
+      return false;
+    names.push_back(name);
+  }
+  return true;
+}
+
+void writeNames(std::ofstream& file, const std::vector<std::string>& names) {
+  file << ' ' << names.size();
+  for (const std::string& name : names)
+    file << ' ' << name;
+}
+} // namespace
+
+void LibraryIndex::addProcedure(Procedure procedure) {
+  auto [it, inserted] = this->procedurePositions.emplace(procedure.name, this->procedures.size());
+  if (!inserted) {
+    logsys::get()->error("Procedure {} is defined twice in the library", procedure.name);
+    throw std::runtime_error("Procedure defined twice in the library");
+  }
+  this->procedures.push_back(std::move(procedure));
+}
+
+const LibraryIndex::Procedure* LibraryIndex::getProcedure(const std::string& name) const {
+  auto it = this->procedurePositions.find(name);
+  return it == this->procedurePositions.end() ? nullptr : &this->procedures[it->second];
+}
+
+void LibraryIndex::writeToFile(const std::string& fileName) const {
+  std::ofstream file(fileName);
+  if (!file) {
+    logsys::get()->error("Could not open library index {}", fileName);
+    throw std::runtime_error("Error writing library index");
+  }
+
+  // "global <name> <type>" lines followed by
+  // "procedure <name> <read count> <reads>... <write count> <writes>..." lines.
+  file << libraryIndexHeader << '\n';
+  for (const auto& [name, type] : this->globals)
+    file << "global " << name << ' ' << getValueType(type) << '\n';
+  for (const Procedure& procedure : this->procedures) {
+    file << "procedure " << procedure.name;
+    writeNames(file, procedure.reads);
+    writeNames(file, procedure.writes);
+    file << '\n';
+  }
+}
+
+LibraryIndex LibraryIndex::readFromFile(const std::string& fileName) {
+  std::ifstream file(fileName);
+  if (!file) {
+    logsys::get()->error("Could not open library index {}", fileName);
+    throw std::runtime_error("Error reading library index");
+  }
+
+  std::string line;
+  if (!std::getline(file, line) || line != libraryIndexHeader) {
+    logsys::get()->error("File {} is not a hebe library index", fileName);
+    throw std::runtime_error("Invalid library index");
+  }
+
+  LibraryIndex index;
+  while (std::getline(file, line)) {
+    if (line.empty())
+      continue;
+
+    std::istringstream fields(line);
+    std::string kind;
+    bool valid = false;
+    fields >> kind;
+
+    if (kind == "global") {
+      std::string name;
+      std::string typeName;
+      if (fields >> name >> typeName) {
+        for (ValueType type : {ValueType::I64, ValueType::F32, ValueType::F64}) {
+          if (typeName == getValueType(type)) {
+            index.addGlobal(name, type);
+            valid = true;
+          }
+        }
+      }
+    } else if (kind == "procedure") {
+      Procedure procedure;
+      valid = (fields >> procedure.name) && readNames(fields, procedure.reads) &&
+              readNames(fields, procedure.writes);
+      if (valid)
+        index.addProcedure(std::move(procedure));
+    }
+
+    if (!valid) {
+      logsys::get()->error("Malformed library index entry '{}' in {}", line, fileName);
+      throw std::runtime_error("Invalid library index");
+    }
+  }
+
+  return index;
+}
@@ -1,4 +1,5 @@
 #include "logging.h"
+#include <spdlog/async.h>
 #include <spdlog/sinks/basic_file_sink.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
 
@@ -8,12 +9,22 @@ std::shared_ptr<spdlog::logger> g_logger;
 
 namespace logsys {
 
-void configureShinks() {
+void configureShinks(bool async) {
 
   auto console = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
 
   std::vector<spdlog::sink_ptr> sinks{console};
-  g_logger = std::make_shared<spdlog::logger>("hebe", sinks.begin(), sinks.end());
+
+  if (async) {
+    // Formatting and I/O run in a background thread fed by a ring buffer. When the buffer is full
+    // the oldest message is dropped instead of blocking the caller.
+    spdlog::init_thread_pool(asyncQueueSize, 1);
+    g_logger = std::make_shared<spdlog::async_logger>("hebe", sinks.begin(), sinks.end(),
+                                                      spdlog::thread_pool(),
+                                                      spdlog::async_overflow_policy::overrun_oldest);
+  } else {
+    g_logger = std::make_shared<spdlog::logger>("hebe", sinks.begin(), sinks.end());
+  }
 
   // Default level: info (use debug while developing)
   g_logger->set_level(spdlog::level::info);
@@ -24,15 +35,24 @@ void configureShinks() {
   spdlog::set_default_logger(g_logger);
 }
 
-void init() {
+void init(bool async) {
   if (g_logger)
     return;
 
-  configureShinks();
+  configureShinks(async);
+}
+
+void shutdown() {
+  // Flushes pending messages of the asynchronous logger.
+  if (g_logger)
+    g_logger->flush();
+  spdlog::shutdown();
 }
 
-std::shared_ptr<spdlog::logger> get() {
-  return g_logger ? g_logger : spdlog::default_logger();
+const std::shared_ptr<spdlog::logger>& get() {
+  // Returned by reference so that logging does not touch the reference count. The logger is never
+  // created here, as the first call could come from any thread.
+  return g_logger;
 }
 
-} // namespace logsys
\ No newline at end of file
+} // namespace logsys
@@ -1,10 +1,25 @@
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
 #include "ast/ast.h"
 #include "compiler.h"
+#include "interpreter/interpreter.h"
 #include "logging.h"
+#include "options.h"
+#include "pipeline/streaming.h"
+#include "tracing.h"
 
 extern int yyparse(); // Declaration of the parsing function.
 extern ASTNode* root; // Defined in grammar.
 extern FILE* yyin;    // Defined in grammar.
+extern int yylineno;  // Defined in the lexer.
+
+typedef struct yy_buffer_state* YY_BUFFER_STATE;
+extern YY_BUFFER_STATE yy_scan_string(const char* str);
+extern void yy_delete_buffer(YY_BUFFER_STATE buffer);
 
 constexpr bool isDebug =
 #ifdef HEBE_DEBUG
@@ -13,34 +28,178 @@ constexpr bool isDebug =
     false;
 #endif
 
+// Runs the generated code, printing the intermediate results in debug builds.
+int optimizeAndRun(Compiler& compiler, bool hasAST) {
+  compiler.optimize();
+  if (isDebug && hasAST)
+    compiler.printNodeTree();
+  if (isDebug)
+    compiler.printLLVMIR();
+  if (isDebug)
+    compiler.exportIRToFile("output_code.ll");
+  return compiler.runJIT();
+}
+
+// Whether auto mode may use the interpreter. Options that only change the generated code, the
+// state file, whose slots are linked into it, and the libraries, which only exist as bitcode, need
+// the JIT. So does --low-memory, which releases the IR and reports the memory used by the JIT.
+bool allowsInterpreter(const CompilerOptions& options) {
+  return !options.stream && !options.tiered && !options.debugInfo && !options.lowMemory &&
+         options.profileGenerate.empty() && options.profileUse.empty() &&
+         options.stateFile.empty() && options.libraries.empty() && !options.fastMath &&
+         !options.fpContract && !options.fpReassoc && !options.fpNoNaNs && !options.fpNoInfs &&
+         !options.fpApproxRecip;
+}
+
+// Runs the program in the interpreter if it is selected. In auto mode that happens when the
+// estimated cost of the program is below the threshold, as starting the JIT would take longer
+// than interpreting it. Returns false if the program has to run in the JIT.
+bool runInterpreted(const CompilerOptions& options, int& exitCode) {
+  if (options.executionMode == ExecutionMode::JIT ||
+      (options.executionMode == ExecutionMode::Auto && !allowsInterpreter(options)))
+    return false;
+
+  Interpreter interpreter(root, options);
+  interpreter.compile();
+
+  uint64_t cost = interpreter.getEstimatedCost();
+  if (options.executionMode == ExecutionMode::Auto && cost > options.interpreterThreshold) {
+    HEBE_LOG_DEBUG("Estimated cost {} above the interpreter threshold, using the JIT", cost);
+    return false;
+  }
+
+  exitCode = interpreter.run();
+  return true;
+}
+
+// Parses every input file and compiles their procedures into one library.
+int buildLibrary(const CompilerOptions& options) {
+  std::vector<std::string> files{options.inputFile};
+  files.insert(files.end(), options.libraryInputFiles.begin(), options.libraryInputFiles.end());
+
+  ProgramNode* library = new ProgramNode();
+  for (const std::string& file : files) {
+    std::ifstream input(file);
+    if (!input) {
+      logsys::get()->error("Could not open {}", file);
+      delete library;
+      return 1;
+    }
+    std::stringstream text;
+    text << input.rdbuf();
+
+    int parseResult;
+    {
+      HEBE_TRACE_SCOPE("parse");
+      yylineno = 1;
+      YY_BUFFER_STATE buffer = yy_scan_string(text.str().c_str());
+      parseResult = yyparse();
+      yy_delete_buffer(buffer);
+    }
+    if (parseResult != 0) {
+      logsys::get()->error("Parsing error occurred in {}!", file);
+      delete library;
+      return 1;
+    }
+
+    // The items of every file become items of the library. Procedures remember their file, as
+    // the lines of every file start at 1.
+    ProgramNode* program = static_cast<ProgramNode*>(root);
+    std::vector<ASTNode*> items = program->getItems();
+    for (size_t i = 0; i < items.size(); i++) {
+      if (items[i]->type == NodeType::Procedure)
+        static_cast<ProcedureNode*>(items[i])->file = file;
+      library->append(items[i], program->getLine(i));
+    }
+    // The library owns the items now.
+    items.clear();
+    program->takeChildren(items);
+    delete root;
+    root = nullptr;
+  }
+
+  Compiler compiler = Compiler(library, options);
+  compiler.generateLibrary();
+  compiler.optimize();
+  compiler.writeLibrary(options.libraryOutput);
+
+  delete library;
+  return 0;
+}
+
 int main(int argc, char** argv) {
+  // Created before any other thread exists, parsing the options already logs.
+  logsys::init();
+
+  CompilerOptions options;
+  try {
+    options = parseOptions(argc, argv);
+  } catch (const std::runtime_error&) {
+    return 1;
+  }
+
+  // The logging mode is only known once the options are parsed.
+  if (options.asyncLog)
+    logsys::configureShinks(true);
+  logsys::get()->set_level(spdlog::level::from_str(options.logLevel));
+
+  if (!options.traceFile.empty())
+    tracing::enable();
+
+  // Libraries are compiled from files and never run.
+  if (!options.libraryOutput.empty()) {
+    int exitCode = buildLibrary(options);
+    if (!options.traceFile.empty())
+      tracing::writeChromeTrace(options.traceFile);
+    logsys::shutdown();
+    return exitCode;
+  }
 
   // Read code file.
-  if (argc > 1) {
-    yyin = fopen(argv[1], "r");
+  if (!options.inputFile.empty()) {
+    yyin = fopen(options.inputFile.c_str(), "r");
     if (!yyin) {
       perror("fopen");
       return 1;
     }
   }
 
-  int exitCode;
-
-  // Call yyparse() and check its return value for errors
-  if (yyparse() == 0) {
-    Compiler compiler = Compiler(root);
-    compiler.generateCode();
-    if (isDebug)
-      compiler.printNodeTree();
-    if (isDebug)
-      compiler.printLLVMIR();
-    if (isDebug)
-      compiler.exportIRToFile("output_code.ll");
-    exitCode = compiler.runJIT();
+  int exitCode = 1;
+
+  if (options.stream) {
+    // Streamed programs are generated while parsing and never exist as a whole AST.
+    Compiler compiler = Compiler(nullptr, options);
+    if (parseAndGenerateStreamed(compiler, options.streamThreads, options.streamQueueCapacity) ==
+        0)
+      exitCode = optimizeAndRun(compiler, false);
+    else
+      logsys::get()->error("Parsing error occurred!");
   } else {
-    logsys::get()->error("Parsing error occurred!");
-    return 1;
+    int parseResult;
+    {
+      HEBE_TRACE_SCOPE("parse");
+      parseResult = yyparse();
+    }
+
+    // Check the return value of yyparse() for errors
+    if (parseResult != 0) {
+      logsys::get()->error("Parsing error occurred!");
+    } else if (!runInterpreted(options, exitCode)) {
+      Compiler compiler = Compiler(root, options);
+      compiler.generateCode();
+
+      // Only the IR is needed from now on.
+      if (options.lowMemory) {
+        compiler.releaseAST();
+        root = nullptr;
+      }
+      exitCode = optimizeAndRun(compiler, !options.lowMemory);
+    }
   }
 
+  if (!options.traceFile.empty())
+    tracing::writeChromeTrace(options.traceFile);
+
+  logsys::shutdown();
   return exitCode;
-}
+}
\ No newline at end of file
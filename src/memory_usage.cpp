@@ -0,0 +1,25 @@
+#include "memory_usage.h"
+
+#include <fstream>
+#include <unistd.h>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+uint64_t getResidentMemory() {
+  // The second field of statm is the number of resident pages.
+  std::ifstream statm("/proc/self/statm");
+  uint64_t totalPages = 0;
+  uint64_t residentPages = 0;
+  if (!(statm >> totalPages >> residentPages))
+    return 0;
+
+  return residentPages * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+}
+
+void trimHeap() {
+#ifdef __GLIBC__
+  malloc_trim(0);
+#endif
+}
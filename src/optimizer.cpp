@@ -0,0 +1,83 @@
+#include "optimizer.h"
+
+#include <llvm/Analysis/TargetLibraryInfo.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/TargetParser/Host.h>
+#include <llvm/TargetParser/Triple.h>
+#include <stdexcept>
+
+#include "logging.h"
+
+namespace {
+
+struct VectorLibraryInfo {
+  const char* name;
+  llvm::TargetLibraryInfoImpl::VectorLibrary library;
+  const char* path;
+};
+
+// Vector math libraries that can be selected with --veclib.
+constexpr VectorLibraryInfo vectorLibraries[] = {
+    {"SVML", llvm::TargetLibraryInfoImpl::SVML, "libsvml.so"},
+    {"SLEEF", llvm::TargetLibraryInfoImpl::SLEEFGNUABI, "libsleefgnuabi.so"},
+    {"ArmPL", llvm::TargetLibraryInfoImpl::ArmPL, "libamath.so"},
+    {"AMDLIBM", llvm::TargetLibraryInfoImpl::AMDLIBM, "libalm.so"},
+    {"Accelerate", llvm::TargetLibraryInfoImpl::Accelerate,
+     "/System/Library/Frameworks/Accelerate.framework/Accelerate"},
+};
+
+const VectorLibraryInfo* findVectorLibrary(const std::string& name) {
+  for (const VectorLibraryInfo& library : vectorLibraries)
+    if (name == library.name)
+      return &library;
+  return nullptr;
+}
+
+} // namespace
+
+void optimizeModule(llvm::Module& module, unsigned optLevel, llvm::TargetMachine* targetMachine,
+                    const std::string& vectorLibrary) {
+  // Level 0 leaves the IR as generated.
+  if (optLevel == 0)
+    return;
+
+  llvm::OptimizationLevel level = optLevel == 1   ? llvm::OptimizationLevel::O1
+                                  : optLevel == 2 ? llvm::OptimizationLevel::O2
+                                                  : llvm::OptimizationLevel::O3;
+
+  // Analysis managers must be declared in this order so that they are destroyed correctly.
+  llvm::LoopAnalysisManager LAM;
+  llvm::FunctionAnalysisManager FAM;
+  llvm::CGSCCAnalysisManager CGAM;
+  llvm::ModuleAnalysisManager MAM;
+
+  // Tell the vectorizers which vector versions of the math functions exist. Registered before the
+  // default analyses so that they do not replace it.
+  llvm::Triple triple(targetMachine ? targetMachine->getTargetTriple().str()
+                                    : llvm::sys::getProcessTriple());
+  llvm::TargetLibraryInfoImpl libraryInfo(triple);
+  if (!vectorLibrary.empty()) {
+    const VectorLibraryInfo* library = findVectorLibrary(vectorLibrary);
+    if (!library) {
+      logsys::get()->error("Unknown vector library {}", vectorLibrary);
+      throw std::runtime_error("Unknown vector library");
+    }
+    libraryInfo.addVectorizableFunctionsFromVecLib(library->library, triple);
+  }
+  FAM.registerPass([&] { return llvm::TargetLibraryAnalysis(libraryInfo); });
+
+  llvm::PassBuilder PB(targetMachine);
+  PB.registerModuleAnalyses(MAM);
+  PB.registerCGSCCAnalyses(CGAM);
+  PB.registerFunctionAnalyses(FAM);
+  PB.registerLoopAnalyses(LAM);
+  PB.crossRegisterProxies(LAM, FAM, CGAM, MAM);
+
+  llvm::ModulePassManager MPM = PB.buildPerModuleDefaultPipeline(level);
+  MPM.run(module, MAM);
+}
+
+const char* getVectorLibraryPath(const std::string& name) {
+  const VectorLibraryInfo* library = findVectorLibrary(name);
+  return library ? library->path : nullptr;
+}
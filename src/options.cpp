@@ -0,0 +1,195 @@
+#include "options.h"
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+#include "logging.h"
+#include "optimizer.h"
+
+namespace {
+
+// Returns true if arg starts with prefix and stores the remaining text in value.
+// Options that match the prefix but carry no value are rejected.
+bool matchOption(const std::string& arg, const std::string& prefix, std::string& value) {
+  if (arg.compare(0, prefix.size(), prefix) != 0)
+    return false;
+
+  value = arg.substr(prefix.size());
+  if (value.empty()) {
+    logsys::get()->error("Option {} requires a value", prefix);
+    throw std::runtime_error("Option requires a value");
+  }
+
+  return true;
+}
+
+// Converts the value of a numeric option.
+uint64_t parseUnsigned(const std::string& arg, const std::string& value) {
+  size_t parsed = 0;
+  uint64_t number = 0;
+  try {
+    number = std::stoull(value, &parsed);
+  } catch (const std::exception&) {
+    parsed = 0;
+  }
+
+  if (parsed != value.size() || value[0] == '-') {
+    logsys::get()->error("Option {} expects a positive integer", arg);
+    throw std::runtime_error("Option expects a positive integer");
+  }
+
+  return number;
+}
+
+} // namespace
+
+CompilerOptions parseOptions(int argc, char** argv) {
+  CompilerOptions options;
+  bool optLevelGiven = false;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    std::string value;
+
+    if (arg == "-O0" || arg == "-O1" || arg == "-O2" || arg == "-O3") {
+      options.optLevel = static_cast<unsigned>(arg[2] - '0');
+      optLevelGiven = true;
+    } else if (matchOption(arg, "--veclib=", value)) {
+      if (!getVectorLibraryPath(value)) {
+        logsys::get()->error("Unknown vector library {}", value);
+        throw std::runtime_error("Unknown vector library");
+      }
+      options.vectorLibrary = value;
+    } else if (arg == "--fast-math") {
+      options.fastMath = true;
+    } else if (arg == "--fp-contract") {
+      options.fpContract = true;
+    } else if (arg == "--fp-reassoc") {
+      options.fpReassoc = true;
+    } else if (arg == "--fp-no-nans") {
+      options.fpNoNaNs = true;
+    } else if (arg == "--fp-no-infs") {
+      options.fpNoInfs = true;
+    } else if (arg == "--fp-arcp") {
+      options.fpApproxRecip = true;
+    } else if (matchOption(arg, "--profile-generate=", value)) {
+      options.profileGenerate = value;
+    } else if (matchOption(arg, "--profile-use=", value)) {
+      options.profileUse = value;
+    } else if (arg == "--tiered") {
+      options.tiered = true;
+    } else if (matchOption(arg, "--tier-up-threshold=", value)) {
+      options.tierUpThreshold = parseUnsigned(arg, value);
+    } else if (arg == "--low-memory") {
+      options.lowMemory = true;
+    } else if (arg == "-g") {
+      options.debugInfo = true;
+    } else if (arg == "--perf") {
+      options.perf = true;
+      options.debugInfo = true;
+    } else if (arg == "--gdb") {
+      options.gdb = true;
+      options.debugInfo = true;
+    } else if (matchOption(arg, "--state=", value)) {
+      options.stateFile = value;
+    } else if (arg == "--state-readonly") {
+      options.stateReadOnly = true;
+    } else if (matchOption(arg, "--emit-library=", value)) {
+      options.libraryOutput = value;
+    } else if (matchOption(arg, "--library=", value)) {
+      options.libraries.push_back(value);
+    } else if (matchOption(arg, "--exec=", value)) {
+      if (value == "auto") {
+        options.executionMode = ExecutionMode::Auto;
+      } else if (value == "jit") {
+        options.executionMode = ExecutionMode::JIT;
+      } else if (value == "interp") {
+        options.executionMode = ExecutionMode::Interpreter;
+      } else {
+        logsys::get()->error("Unknown execution mode {}", value);
+        throw std::runtime_error("Unknown execution mode");
+      }
+    } else if (matchOption(arg, "--interp-threshold=", value)) {
+      options.interpreterThreshold = parseUnsigned(arg, value);
+    } else if (matchOption(arg, "--threads=", value)) {
+      options.threads = parseUnsigned(arg, value);
+    } else if (matchOption(arg, "--trace=", value)) {
+      options.traceFile = value;
+    } else if (arg == "--async-log") {
+      options.asyncLog = true;
+    } else if (matchOption(arg, "--log-level=", value)) {
+      if (value != "trace" && value != "debug" && value != "info" && value != "warn" &&
+          value != "error") {
+        logsys::get()->error("Unknown log level {}", value);
+        throw std::runtime_error("Unknown log level");
+      }
+      options.logLevel = value;
+    } else if (arg == "--stream") {
+      options.stream = true;
+    } else if (arg == "--stream-threads") {
+      options.stream = true;
+      options.streamThreads = true;
+    } else if (matchOption(arg, "--stream-queue=", value)) {
+      options.streamQueueCapacity = parseUnsigned(arg, value);
+    } else if (!arg.empty() && arg[0] != '-' && options.inputFile.empty()) {
+      options.inputFile = arg;
+    } else if (!arg.empty() && arg[0] != '-') {
+      options.libraryInputFiles.push_back(arg);
+    } else {
+      logsys::get()->error("Unknown option {}", arg);
+      throw std::runtime_error("Unknown option");
+    }
+  }
+
+  // The profile only guides the optimization pipeline, which tiered mode and -O0 skip. Without an
+  // explicit level it selects -O2.
+  if (!options.profileUse.empty() && options.tiered) {
+    logsys::get()->error("--profile-use can not be used with --tiered");
+    throw std::runtime_error("Option not supported in tiered mode");
+  }
+  if (!options.profileUse.empty() && options.optLevel == 0) {
+    if (optLevelGiven) {
+      logsys::get()->error("--profile-use requires an optimization level above -O0");
+      throw std::runtime_error("Option requires optimizations");
+    }
+    options.optLevel = 2;
+  }
+
+  // Tiered mode keeps a bitcode copy of the whole module for the entire run.
+  if (options.lowMemory && options.tiered) {
+    logsys::get()->error("--low-memory can not be used with --tiered");
+    throw std::runtime_error("Option not supported in tiered mode");
+  }
+
+  if (options.stateReadOnly && options.stateFile.empty()) {
+    logsys::get()->error("--state-readonly requires --state");
+    throw std::runtime_error("Option requires --state");
+  }
+
+  if (!options.libraryInputFiles.empty() && options.libraryOutput.empty()) {
+    logsys::get()->error("Only libraries can be compiled from several input files");
+    throw std::runtime_error("Several input files require --emit-library");
+  }
+
+  // A library is only compiled, the options of a run do not apply to it.
+  if (!options.libraryOutput.empty() &&
+      (options.inputFile.empty() || options.stream || options.tiered ||
+       !options.profileGenerate.empty() || !options.stateFile.empty() ||
+       !options.libraries.empty() || options.executionMode == ExecutionMode::Interpreter)) {
+    logsys::get()->error("--emit-library requires input files and can not be used with options of "
+                         "the program run");
+    throw std::runtime_error("Option not supported when compiling a library");
+  }
+
+  // The interpreter never generates code, so these options could not be honored.
+  if (options.executionMode == ExecutionMode::Interpreter &&
+      (options.stream || options.tiered || options.perf || options.gdb || options.debugInfo ||
+       options.lowMemory || !options.profileGenerate.empty() || !options.profileUse.empty() ||
+       !options.stateFile.empty() || !options.libraries.empty())) {
+    logsys::get()->error("--exec=interp can not be used with options of the generated code");
+    throw std::runtime_error("Option not supported by the interpreter");
+  }
+
+  return options;
+}
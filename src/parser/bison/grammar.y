@@ -1,59 +1,112 @@
 %code requires {
+    #include <vector>
     #include "ast/ast.h"
     #include "logging.h"
 }
 
 %{
+#include <cstdlib>
+#include <functional>
 #include <iostream>
 #include <memory>
 #include "ast/ast.h"
+#include "ast/expression_table.h"
 
 extern int yylex();
 void yyerror(const char *s);
 ASTNode* root;
+// When set, every top level item is handed to it with its source line as soon as it is parsed
+// instead of being appended to root. The handler takes ownership of the node.
+std::function<void(ASTNode*, int)> lineHandler;
+// Makes equal expressions of a program one shared node. Cleared before the items it built can be
+// deleted, which happens when the parse ends or, when streaming, as soon as an item is handed on.
+static ExpressionTable expressions;
+
+// A word alone in a line is a procedure call, not a variable read.
+static ASTNode* toStatement(ASTNode* node) {
+  if (node->type != NodeType::Variable)
+    return node;
+
+  ASTNode* call = new ProcedureCallNode(static_cast<VariableNode*>(node)->name);
+  expressions.release(node);
+  return call;
+}
 %}
 
+%locations
+
 %union {
     double fval;
-    char* sval;
+    long long ival;
+    // Interned by the lexer, never freed by the parser.
+    const char* sval;
     ASTNode* node;
+    std::vector<ASTNode*>* nodes;
 }
 
-%token SAVE IN CREATE DONE NEWLINE SHOW ARROW
-%token <fval> NUMBER
+%token SAVE IN CREATE DONE NEWLINE SHOW ARROW PARALLEL
+%token <fval> NUMBER FNUMBER
+%token <ival> INTEGER
 %token <sval> WORD
+%precedence VARIABLE
+%precedence '('
 %left '+' '-'
 %left '*' '/'
 
-%type <node> input line expression assignment procedureBody procedure procedureCall showCall showArguments
+%type <node> input line expression assignment procedureBody procedure showCall parallel
+%type <nodes> arguments showArguments
 
 %%
 
+program
+  : input                       { expressions.clear(); }
+  ;
+
 input
-  : /* empty */                 { $$ = new ProgramNode(); root = $$; }
+  : /* empty */                 { expressions.clear(); $$ = new ProgramNode(); root = $$; }
   | input line                  {
-                                  if ($2) static_cast<ProgramNode*>($1)->append($2);
+                                  if ($2 && lineHandler) {
+                                    expressions.clear();
+                                    lineHandler($2, @2.first_line);
+                                  } else if ($2) {
+                                    static_cast<ProgramNode*>($1)->append($2, @2.first_line);
+                                  }
                                   $$ = $1;
                                 }
   ;
 
+// The line of an item is kept by the list holding it. An expression item can be a node shared
+// with other lines.
 line
-  : expression                  { $$ = $1; }
+  : expression                  { $$ = toStatement($1); }
   | assignment                  { $$ = $1; }
   | procedure                   { $$ = $1; }
-  | procedureCall               { $$ = $1; }
+  | showCall                    { $$ = $1; }
+  | parallel                    { $$ = $1; }
   | NEWLINE                     { $$ = nullptr; }
   ;
 
 expression
-  : NUMBER                      { $$ = new NumberNode($1); }
-  | expression '+' expression    { $$ = new BinaryOpNode('+', $1, $3); }
-  | expression '-' expression    { $$ = new BinaryOpNode('-', $1, $3); }
-  | expression '*' expression    { $$ = new BinaryOpNode('*', $1, $3); }
-  | expression '/' expression    { $$ = new BinaryOpNode('/', $1, $3); }
+  : NUMBER                      { $$ = expressions.intern(new NumberNode($1, ValueType::F64)); }
+  | FNUMBER                     { $$ = expressions.intern(new NumberNode($1, ValueType::F32)); }
+  | INTEGER                     { $$ = expressions.intern(new IntegerNode($1)); }
+  | WORD %prec VARIABLE         { $$ = expressions.intern(new VariableNode($1)); }
+  | WORD '(' arguments ')'      {
+                                  $$ = expressions.intern(new BuiltinCallNode($1, std::move(*$3)));
+                                  delete $3;
+                                }
+  | expression '+' expression    { $$ = expressions.intern(new BinaryOpNode('+', $1, $3)); }
+  | expression '-' expression    { $$ = expressions.intern(new BinaryOpNode('-', $1, $3)); }
+  | expression '*' expression    { $$ = expressions.intern(new BinaryOpNode('*', $1, $3)); }
+  | expression '/' expression    { $$ = expressions.intern(new BinaryOpNode('/', $1, $3)); }
   | '(' expression ')'           { $$ = $2; }
   ;
 
+arguments
+  : expression                  { $$ = new std::vector<ASTNode*>{$1}; }
+  | arguments ',' expression    { $1->push_back($3); $$ = $1; }
+  ;
+
 assignment
   : SAVE expression IN WORD      { $$ = new AssignmentNode($4, $2); }
   ;
@@ -61,26 +114,27 @@ assignment
 procedureBody
   :                             { $$ = new ProcedureBodyNode(); }
   | procedureBody line          {
-                                  if ($1) static_cast<ProcedureBodyNode*>($1)->append($2);
+                                  if ($1)
+                                    static_cast<ProcedureBodyNode*>($1)->append($2, @2.first_line);
                                   $$ = $1;
                                 }
   ;
 
 procedure
-  : CREATE WORD NEWLINE procedureBody DONE       { $$ = new ProcedureNode($2, $4); }
+  : CREATE WORD NEWLINE procedureBody DONE       { $$ = new ProcedureNode($2, $4, @1.first_line); }
   ;
 
-procedureCall
-  : WORD                        { $$ = new ProcedureCallNode($1); }
+parallel
+  : PARALLEL NEWLINE procedureBody DONE          { $$ = new ParallelNode($3); }
   ;
 
 showCall
-  : SHOW showArguments
+  : SHOW showArguments          { $$ = new ShowNode(std::move(*$2)); delete $2; }
   ;
 
 showArguments
-  : ARROW WORD showArguments
-  | WORD showArguments
+  : expression                        { $$ = new std::vector<ASTNode*>{$1}; }
+  | showArguments ARROW expression    { $1->push_back($3); $$ = $1; }
   ;
 
 %%
@@ -0,0 +1,94 @@
+#include "pipeline/streaming.h"
+
+#include <functional>
+#include <optional>
+#include <thread>
+#include <utility>
+
+#include "ast/ast.h"
+#include "pipeline/bounded_queue.h"
+#include "tracing.h"
+
+extern int yyparse();                             // Declaration of the parsing function.
+extern std::function<void(ASTNode*, int)> lineHandler; // Defined in grammar.
+
+namespace {
+
+// Thrown through yyparse() to stop the parser thread once code generation has failed.
+struct ParsingStopped {};
+
+int parseAndGenerateInline(Compiler& compiler) {
+  HEBE_TRACE_SCOPE("parseAndGenerate");
+
+  lineHandler = [&compiler](ASTNode* node, int line) { compiler.streamItem(node, line); };
+
+  // Code generation errors are thrown from inside yyparse().
+  int parseResult;
+  try {
+    parseResult = yyparse();
+  } catch (...) {
+    lineHandler = nullptr;
+    throw;
+  }
+
+  lineHandler = nullptr;
+  return parseResult;
+}
+
+int parseAndGenerateThreaded(Compiler& compiler, size_t queueCapacity) {
+  // Items with their source line.
+  BoundedQueue<std::pair<ASTNode*, int>> queue(queueCapacity);
+  int parseResult = 1;
+
+  std::thread parser([&queue, &parseResult] {
+    HEBE_TRACE_SCOPE("parse");
+
+    // Code generation has failed when an item can not be queued anymore. The rest of the input is
+    // not parsed.
+    lineHandler = [&queue](ASTNode* node, int line) {
+      if (!queue.push({node, line})) {
+        delete node;
+        throw ParsingStopped();
+      }
+    };
+    try {
+      parseResult = yyparse();
+    } catch (const ParsingStopped&) {
+      parseResult = 1;
+    }
+    lineHandler = nullptr;
+
+    queue.close();
+  });
+
+  try {
+    HEBE_TRACE_SCOPE("generateCode");
+    while (std::optional<std::pair<ASTNode*, int>> item = queue.pop())
+      compiler.streamItem(item->first, item->second);
+  } catch (...) {
+    // The parser stops at its next item. The items it already queued are never generated.
+    queue.close();
+    parser.join();
+    while (std::optional<std::pair<ASTNode*, int>> item = queue.pop())
+      delete item->first;
+    throw;
+  }
+
+  parser.join();
+  return parseResult;
+}
+
+} // namespace
+
+int parseAndGenerateStreamed(Compiler& compiler, bool threaded, size_t queueCapacity) {
+  compiler.beginStreaming();
+
+  int parseResult = threaded ? parseAndGenerateThreaded(compiler, queueCapacity)
+                             : parseAndGenerateInline(compiler);
+
+  // A program with parse errors is incomplete, so "run" is not finished.
+  if (parseResult == 0)
+    compiler.finishStreaming();
+
+  return parseResult;
+}
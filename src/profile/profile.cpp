@@ -0,0 +1,69 @@
+#include "profile/profile.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include "logging.h"
+
+namespace {
+// First line of every profile file. Changing the format requires changing the version.
+const std::string profileHeader = "# hebe profile v1";
+} // namespace
+
+uint64_t Profile::getCount(const std::string& name) const {
+  auto it = this->counts.find(name);
+  return it == this->counts.end() ? 0 : it->second;
+}
+
+uint64_t Profile::getMaxCount() const {
+  uint64_t maxCount = 0;
+  for (const auto& [name, count] : this->counts)
+    maxCount = std::max(maxCount, count);
+  return maxCount;
+}
+
+void Profile::writeToFile(const std::string& fileName) const {
+  std::ofstream file(fileName);
+  if (!file) {
+    logsys::get()->error("Could not open profile file {}", fileName);
+    throw std::runtime_error("Error writing profile file");
+  }
+
+  // One "<procedure> <count>" pair per line.
+  file << profileHeader << '\n';
+  for (const auto& [name, count] : this->counts)
+    file << name << ' ' << count << '\n';
+}
+
+Profile Profile::readFromFile(const std::string& fileName) {
+  std::ifstream file(fileName);
+  if (!file) {
+    logsys::get()->error("Could not open profile file {}", fileName);
+    throw std::runtime_error("Error reading profile file");
+  }
+
+  std::string line;
+  if (!std::getline(file, line) || line != profileHeader) {
+    logsys::get()->error("File {} is not a hebe profile", fileName);
+    throw std::runtime_error("Invalid profile file");
+  }
+
+  Profile profile;
+  while (std::getline(file, line)) {
+    if (line.empty())
+      continue;
+
+    std::istringstream fields(line);
+    std::string name;
+    uint64_t count;
+    if (!(fields >> name >> count)) {
+      logsys::get()->error("Malformed profile entry '{}' in {}", line, fileName);
+      throw std::runtime_error("Invalid profile file");
+    }
+    profile.setCount(name, count);
+  }
+
+  return profile;
+}
@@ -0,0 +1,48 @@
+#include "runtime/parallel.h"
+
+#include <utility>
+
+#include "runtime/show.h"
+#include "runtime/work_stealing_pool.h"
+
+namespace {
+
+size_t configuredThreadCount = 0;
+
+// The pool is created by the first parallel block so that programs without them start no threads.
+WorkStealingPool& getPool() {
+  static WorkStealingPool pool(configuredThreadCount);
+  return pool;
+}
+
+} // namespace
+
+void configureParallelRuntime(size_t threadCount) { configuredThreadCount = threadCount; }
+
+void spawnParallelTask(void* group, std::function<void()> task) {
+  getPool().spawn(*static_cast<WorkStealingPool::TaskGroup*>(group), [task = std::move(task)] {
+    task();
+    // Pool threads live until exit, so their output is written when each task ends to keep it
+    // before the output that follows the block.
+    hebe_show_flush();
+  });
+}
+
+extern "C" {
+
+void* hebe_parallel_begin() {
+  // Output shown before the block must come before the output of its tasks.
+  hebe_show_flush();
+  return new WorkStealingPool::TaskGroup();
+}
+
+void hebe_parallel_spawn(void* group, void (*procedure)()) {
+  spawnParallelTask(group, procedure);
+}
+
+void hebe_parallel_join(void* group) {
+  WorkStealingPool::TaskGroup* taskGroup = static_cast<WorkStealingPool::TaskGroup*>(group);
+  getPool().join(*taskGroup);
+  delete taskGroup;
+}
+}
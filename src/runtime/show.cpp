@@ -0,0 +1,72 @@
+#include "runtime/show.h"
+
+#include <charconv>
+#include <memory>
+#include <unistd.h>
+
+namespace {
+
+// Longest text a single value can take, including its separator.
+constexpr size_t maxValueLength = 64;
+// Once a line ends with less than this free space the buffer is written, so that lines of
+// different threads are not mixed.
+constexpr size_t lineFlushMargin = 4096;
+
+class OutputBuffer {
+public:
+  ~OutputBuffer() { this->flush(); }
+
+  // Returns the free space of the buffer with room for at least one more value.
+  char* reserve() {
+    if (!this->data)
+      this->data = std::make_unique<char[]>(showBufferSize);
+    if (showBufferSize - this->size < maxValueLength)
+      this->flush();
+    return this->data.get() + this->size;
+  }
+
+  void commit(char* end, int32_t separator) {
+    *end++ = static_cast<char>(separator);
+    this->size = end - this->data.get();
+
+    if (separator == '\n' && showBufferSize - this->size < lineFlushMargin)
+      this->flush();
+  }
+
+  void flush() {
+    size_t written = 0;
+    while (written < this->size) {
+      ssize_t result = ::write(STDOUT_FILENO, this->data.get() + written, this->size - written);
+      if (result <= 0)
+        break;
+      written += static_cast<size_t>(result);
+    }
+    this->size = 0;
+  }
+
+private:
+  std::unique_ptr<char[]> data;
+  size_t size = 0;
+};
+
+thread_local OutputBuffer outputBuffer;
+
+template <typename T> void show(T value, int32_t separator) {
+  char* begin = outputBuffer.reserve();
+  // Floating point values are written with the shortest text that reads back the same value.
+  char* end = std::to_chars(begin, begin + maxValueLength - 1, value).ptr;
+  outputBuffer.commit(end, separator);
+}
+
+} // namespace
+
+extern "C" {
+
+void hebe_show_i64(int64_t value, int32_t separator) { show(value, separator); }
+
+void hebe_show_f32(float value, int32_t separator) { show(value, separator); }
+
+void hebe_show_f64(double value, int32_t separator) { show(value, separator); }
+
+void hebe_show_flush() { outputBuffer.flush(); }
+}
@@ -0,0 +1,258 @@
+#include "runtime/state_file.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+
+#include "logging.h"
+
+namespace {
+// First bytes of every state file.
+constexpr char stateMagic[8] = {'H', 'E', 'B', 'E', 'S', 'T', 'A', 'T'};
+// Every value takes 8 bytes, f32 values use the first 4.
+constexpr size_t slotSize = 8;
+
+size_t alignTo(size_t value, size_t alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+// Directory holding the entry of the file.
+std::string getDirectory(const std::string& path) {
+  size_t slash = path.rfind('/');
+  if (slash == std::string::npos)
+    return ".";
+  return slash == 0 ? "/" : path.substr(0, slash);
+}
+
+bool isValueType(uint32_t type) {
+  return type == static_cast<uint32_t>(ValueType::I64) ||
+         type == static_cast<uint32_t>(ValueType::F32) ||
+         type == static_cast<uint32_t>(ValueType::F64);
+}
+} // namespace
+
+StateFile::StateFile(std::string path, const std::vector<Variable>& variables)
+    : path(std::move(path)) {
+  if (this->map()) {
+    bool complete = true;
+    for (const Variable& variable : variables) {
+      auto it = this->slots.find(variable.name);
+      complete = complete && it != this->slots.end() && it->second.type == variable.type;
+    }
+
+    // Usual case of a warm restart, the file already has the layout of the program.
+    if (complete)
+      return;
+  }
+
+  this->rebuild(variables);
+}
+
+StateFile::~StateFile() { this->unmap(); }
+
+void StateFile::unmap() {
+  if (this->data)
+    munmap(this->data, this->size);
+  this->data = nullptr;
+  this->size = 0;
+}
+
+bool StateFile::map() {
+  int fd = open(this->path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    if (errno == ENOENT)
+      return false;
+    logsys::get()->error("Could not open state file {}: {}", this->path, std::strerror(errno));
+    throw std::runtime_error("Error opening state file");
+  }
+
+  struct stat status;
+  void* mapping = MAP_FAILED;
+  if (fstat(fd, &status) == 0 && static_cast<size_t>(status.st_size) >= sizeof(Header))
+    mapping = mmap(nullptr, status.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+
+  if (mapping == MAP_FAILED) {
+    logsys::get()->error("File {} is not a hebe state file", this->path);
+    throw std::runtime_error("Invalid state file");
+  }
+  this->data = static_cast<char*>(mapping);
+  this->size = status.st_size;
+
+  const Header* header = this->getHeader();
+  if (std::memcmp(header->magic, stateMagic, sizeof(stateMagic)) != 0) {
+    this->unmap();
+    logsys::get()->error("File {} is not a hebe state file", this->path);
+    throw std::runtime_error("Invalid state file");
+  }
+  if (header->version != stateFileVersion) {
+    uint32_t version = header->version;
+    this->unmap();
+    logsys::get()->error("State file {} has version {}, expected version {}", this->path, version,
+                         stateFileVersion);
+    throw std::runtime_error("Unsupported state file version");
+  }
+
+  // Everything the index points to must be inside the file.
+  uint64_t count = header->variableCount;
+  uint64_t entriesEnd = sizeof(Header) + count * sizeof(Entry);
+  bool valid = header->size == this->size && entriesEnd <= header->valuesOffset &&
+               header->valuesOffset % slotSize == 0 && header->valuesOffset <= this->size &&
+               count <= (this->size - header->valuesOffset) / slotSize;
+
+  const Entry* entries = reinterpret_cast<const Entry*>(this->data + sizeof(Header));
+  for (uint64_t i = 0; valid && i < count; i++) {
+    const Entry& entry = entries[i];
+    valid = entry.nameOffset >= entriesEnd && entry.nameOffset <= header->valuesOffset &&
+            entry.nameLength <= header->valuesOffset - entry.nameOffset && isValueType(entry.type);
+    if (valid)
+      this->slots[std::string(this->data + entry.nameOffset, entry.nameLength)] = {
+          header->valuesOffset + i * slotSize, static_cast<ValueType>(entry.type)};
+  }
+
+  if (!valid) {
+    this->slots.clear();
+    this->unmap();
+    logsys::get()->error("State file {} is corrupted", this->path);
+    throw std::runtime_error("Invalid state file");
+  }
+
+  return true;
+}
+
+void StateFile::rebuild(const std::vector<Variable>& variables) {
+  // The variables of the current file keep their order and values. Values that are not copied
+  // start at zero.
+  std::vector<Variable> layout;
+  std::vector<const char*> values;
+  if (this->data) {
+    const Header* header = this->getHeader();
+    const Entry* entries = reinterpret_cast<const Entry*>(this->data + sizeof(Header));
+    for (uint32_t i = 0; i < header->variableCount; i++) {
+      layout.push_back({std::string(this->data + entries[i].nameOffset, entries[i].nameLength),
+                        static_cast<ValueType>(entries[i].type)});
+      values.push_back(this->data + header->valuesOffset + i * slotSize);
+    }
+  }
+
+  std::unordered_map<std::string, size_t> positions;
+  for (size_t i = 0; i < layout.size(); i++)
+    positions[layout[i].name] = i;
+
+  for (const Variable& variable : variables) {
+    auto it = positions.find(variable.name);
+    if (it == positions.end()) {
+      positions[variable.name] = layout.size();
+      layout.push_back(variable);
+      values.push_back(nullptr);
+    } else if (layout[it->second].type != variable.type) {
+      logsys::get()->warn("Variable {} changed its type, its saved value is dropped",
+                          variable.name);
+      layout[it->second].type = variable.type;
+      values[it->second] = nullptr;
+    }
+  }
+
+  size_t namesSize = 0;
+  for (const Variable& variable : layout)
+    namesSize += variable.name.size();
+
+  // Values start on their own page so that the index pages are never written.
+  size_t valuesOffset = alignTo(sizeof(Header) + layout.size() * sizeof(Entry) + namesSize,
+                                static_cast<size_t>(sysconf(_SC_PAGESIZE)));
+  size_t size = valuesOffset + layout.size() * slotSize;
+
+  // Anonymous memory starts zeroed. The file is only written by checkpoint().
+  void* mapping =
+      mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (mapping == MAP_FAILED) {
+    logsys::get()->error("Could not allocate {} bytes for state file {}", size, this->path);
+    throw std::runtime_error("Error allocating state");
+  }
+  char* data = static_cast<char*>(mapping);
+
+  Header* header = reinterpret_cast<Header*>(data);
+  std::memcpy(header->magic, stateMagic, sizeof(stateMagic));
+  header->version = stateFileVersion;
+  header->variableCount = static_cast<uint32_t>(layout.size());
+  header->generation = this->data ? this->getHeader()->generation : 0;
+  header->valuesOffset = valuesOffset;
+  header->size = size;
+
+  Entry* entries = reinterpret_cast<Entry*>(data + sizeof(Header));
+  size_t nameOffset = sizeof(Header) + layout.size() * sizeof(Entry);
+  std::unordered_map<std::string, Slot> slots;
+  for (size_t i = 0; i < layout.size(); i++) {
+    const Variable& variable = layout[i];
+    entries[i] = {nameOffset, static_cast<uint32_t>(variable.name.size()),
+                  static_cast<uint32_t>(variable.type)};
+    std::memcpy(data + nameOffset, variable.name.data(), variable.name.size());
+    nameOffset += variable.name.size();
+
+    size_t offset = valuesOffset + i * slotSize;
+    if (values[i])
+      std::memcpy(data + offset, values[i], slotSize);
+    slots[variable.name] = {offset, variable.type};
+  }
+
+  this->unmap();
+  this->data = data;
+  this->size = size;
+  this->slots = std::move(slots);
+}
+
+void* StateFile::getSlot(const std::string& name) const {
+  auto it = this->slots.find(name);
+  return it == this->slots.end() ? nullptr : this->data + it->second.offset;
+}
+
+uint64_t StateFile::getGeneration() const { return this->getHeader()->generation; }
+
+void StateFile::checkpoint() {
+  this->getHeader()->generation++;
+
+  // The new snapshot is complete on disk before it replaces the previous one. Each process writes
+  // its own temporary file, the last rename wins.
+  std::string temporaryPath = this->path + ".tmp." + std::to_string(getpid());
+  int fd = open(temporaryPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+
+  bool written = fd >= 0;
+  size_t offset = 0;
+  while (written && offset < this->size) {
+    ssize_t count = write(fd, this->data + offset, this->size - offset);
+    if (count < 0 && errno == EINTR)
+      continue;
+    written = count > 0;
+    if (written)
+      offset += static_cast<size_t>(count);
+  }
+  written = written && fsync(fd) == 0;
+  if (fd >= 0)
+    written = close(fd) == 0 && written;
+  written = written && rename(temporaryPath.c_str(), this->path.c_str()) == 0;
+
+  if (!written) {
+    int error = errno;
+    unlink(temporaryPath.c_str());
+    this->getHeader()->generation--;
+    logsys::get()->error("Could not write state file {}: {}", this->path, std::strerror(error));
+    throw std::runtime_error("Error writing state file");
+  }
+
+  // The rename only survives a crash once the directory holding the new entry is on disk too.
+  int directory = open(getDirectory(this->path).c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  bool synced = directory >= 0 && fsync(directory) == 0;
+  int error = errno;
+  if (directory >= 0)
+    close(directory);
+  if (!synced) {
+    logsys::get()->error("Could not sync the directory of state file {}: {}", this->path,
+                         std::strerror(error));
+    throw std::runtime_error("Error writing state file");
+  }
+}
@@ -0,0 +1,140 @@
+#include "runtime/work_stealing_pool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <utility>
+
+namespace {
+
+// Pool and queue index of the current thread when it is a worker.
+thread_local const WorkStealingPool* currentPool = nullptr;
+thread_local size_t currentWorker = 0;
+
+// Time a joining thread sleeps before looking for new tasks again while the last tasks of its
+// group run on other threads.
+constexpr auto joinPollInterval = std::chrono::milliseconds(1);
+
+} // namespace
+
+WorkStealingPool::WorkStealingPool(size_t workerCount) {
+  if (workerCount == 0)
+    workerCount = std::max(1u, std::thread::hardware_concurrency());
+
+  for (size_t i = 0; i < workerCount; i++)
+    this->queues.push_back(std::make_unique<WorkerQueue>());
+  for (size_t i = 0; i < workerCount; i++)
+    this->workers.emplace_back(&WorkStealingPool::workerLoop, this, i);
+}
+
+WorkStealingPool::~WorkStealingPool() {
+  {
+    std::lock_guard<std::mutex> lock(this->sleepMutex);
+    this->stopRequested = true;
+  }
+  this->wakeUp.notify_all();
+
+  for (std::thread& worker : this->workers)
+    worker.join();
+}
+
+void WorkStealingPool::spawn(TaskGroup& group, Task task) {
+  group.pending.fetch_add(1, std::memory_order_relaxed);
+
+  // Workers keep their tasks local, other threads share the external queue.
+  WorkerQueue& queue = currentPool == this ? *this->queues[currentWorker] : this->externalQueue;
+  {
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.tasks.push_back({std::move(task), &group});
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(this->sleepMutex);
+    this->queuedTasks++;
+  }
+  this->wakeUp.notify_one();
+}
+
+void WorkStealingPool::join(TaskGroup& group) {
+  while (group.pending.load(std::memory_order_acquire) != 0) {
+    // Help with the pending work instead of blocking a thread.
+    if (std::optional<PendingTask> pendingTask = this->findTask()) {
+      this->runTask(*pendingTask);
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(group.mutex);
+    group.done.wait_for(lock, joinPollInterval,
+                        [&group] { return group.pending.load(std::memory_order_acquire) == 0; });
+  }
+
+  // Wait for the thread that finished the last task to release the group.
+  std::lock_guard<std::mutex> lock(group.mutex);
+}
+
+void WorkStealingPool::workerLoop(size_t index) {
+  currentPool = this;
+  currentWorker = index;
+
+  while (true) {
+    if (std::optional<PendingTask> pendingTask = this->findTask()) {
+      this->runTask(*pendingTask);
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(this->sleepMutex);
+    this->wakeUp.wait(lock, [this] { return this->stopRequested || this->queuedTasks > 0; });
+    if (this->stopRequested && this->queuedTasks == 0)
+      return;
+  }
+}
+
+std::optional<WorkStealingPool::PendingTask> WorkStealingPool::findTask() {
+  auto takeTask = [this](WorkerQueue& queue, bool newest) -> std::optional<PendingTask> {
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty())
+      return std::nullopt;
+
+    PendingTask pendingTask;
+    if (newest) {
+      pendingTask = std::move(queue.tasks.back());
+      queue.tasks.pop_back();
+    } else {
+      pendingTask = std::move(queue.tasks.front());
+      queue.tasks.pop_front();
+    }
+
+    std::lock_guard<std::mutex> sleepLock(this->sleepMutex);
+    this->queuedTasks--;
+    return pendingTask;
+  };
+
+  // Own tasks first, newest first.
+  bool isWorker = currentPool == this;
+  if (isWorker)
+    if (std::optional<PendingTask> pendingTask = takeTask(*this->queues[currentWorker], true))
+      return pendingTask;
+
+  if (std::optional<PendingTask> pendingTask = takeTask(this->externalQueue, false))
+    return pendingTask;
+
+  // Steal the oldest task of another worker, starting from the next one to spread the victims.
+  size_t start = isWorker ? currentWorker + 1 : 0;
+  for (size_t i = 0; i < this->queues.size(); i++) {
+    WorkerQueue& victim = *this->queues[(start + i) % this->queues.size()];
+    if (std::optional<PendingTask> pendingTask = takeTask(victim, false))
+      return pendingTask;
+  }
+
+  return std::nullopt;
+}
+
+void WorkStealingPool::runTask(PendingTask& pendingTask) {
+  pendingTask.task();
+
+  // The count changes under the lock, so a joining thread can not miss the notification nor destroy
+  // the group while it is still in use here.
+  TaskGroup& group = *pendingTask.group;
+  std::lock_guard<std::mutex> lock(group.mutex);
+  if (group.pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    group.done.notify_all();
+}
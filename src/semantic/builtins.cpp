@@ -0,0 +1,25 @@
+#include "semantic/builtins.h"
+
+namespace {
+constexpr BuiltinInfo builtins[] = {
+    {Builtin::Sqrt, "sqrt", 1, false}, {Builtin::Abs, "abs", 1, true},
+    {Builtin::Min, "min", 2, true},    {Builtin::Max, "max", 2, true},
+    {Builtin::Fma, "fma", 3, false},   {Builtin::Floor, "floor", 1, true},
+    {Builtin::Exp, "exp", 1, false},   {Builtin::Log, "log", 1, false},
+    {Builtin::Pow, "pow", 2, false},   {Builtin::Sin, "sin", 1, false},
+    {Builtin::Cos, "cos", 1, false},
+};
+} // namespace
+
+const BuiltinInfo* findBuiltin(const std::string& name) {
+  for (const BuiltinInfo& builtin : builtins)
+    if (name == builtin.name)
+      return &builtin;
+  return nullptr;
+}
+
+ValueType getBuiltinResultType(const BuiltinInfo& builtin, ValueType argumentsType) {
+  if (argumentsType == ValueType::I64 && !builtin.integerVersion)
+    return ValueType::F64;
+  return argumentsType;
+}
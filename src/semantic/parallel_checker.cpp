@@ -0,0 +1,154 @@
+#include "semantic/parallel_checker.h"
+
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "logging.h"
+
+void ParallelChecker::check(ASTNode* rootNode) {
+  if (!rootNode) {
+    logsys::get()->error("No code provided to the parallel checker");
+    throw std::runtime_error("No code provided to the parallel checker");
+  }
+
+  Accesses accesses;
+  this->visit(rootNode, accesses);
+}
+
+void ParallelChecker::checkItem(ASTNode* node) {
+  Accesses accesses;
+  this->visit(node, accesses);
+}
+
+void ParallelChecker::declareProcedure(const std::string& name, Accesses accesses) {
+  this->procedureTable[name] = std::move(accesses);
+}
+
+const ParallelChecker::Accesses*
+ParallelChecker::getProcedureAccesses(const std::string& name) const {
+  auto it = this->procedureTable.find(name);
+  return it == this->procedureTable.end() ? nullptr : &it->second;
+}
+
+void ParallelChecker::visit(ASTNode* node, Accesses& accesses) {
+  switch (node->type) {
+  case NodeType::Program: {
+    for (ASTNode* child : static_cast<ProgramNode*>(node)->getItems())
+      this->visit(child, accesses);
+    break;
+  }
+  case NodeType::ProcedureBody: {
+    for (ASTNode* child : static_cast<ProcedureBodyNode*>(node)->getItems())
+      this->visit(child, accesses);
+    break;
+  }
+  case NodeType::Procedure: {
+    ProcedureNode* procNode = static_cast<ProcedureNode*>(node);
+
+    // Registered first so that recursive calls find the procedure. They add nothing new.
+    this->procedureTable[procNode->name] = Accesses();
+    Accesses procedureAccesses;
+    this->visit(procNode->body, procedureAccesses);
+    this->procedureTable[procNode->name] = std::move(procedureAccesses);
+    break;
+  }
+  case NodeType::ProcedureCall: {
+    // Unknown procedures are reported by the code generation.
+    ProcedureCallNode* callNode = static_cast<ProcedureCallNode*>(node);
+    if (const Accesses* callee = this->getProcedureAccesses(callNode->name)) {
+      accesses.reads.insert(callee->reads.begin(), callee->reads.end());
+      accesses.writes.insert(callee->writes.begin(), callee->writes.end());
+    }
+    break;
+  }
+  case NodeType::Parallel: {
+    this->checkParallel(node);
+    this->visit(static_cast<ParallelNode*>(node)->body, accesses);
+    break;
+  }
+  case NodeType::Assignment: {
+    AssignmentNode* assignNode = static_cast<AssignmentNode*>(node);
+    this->visitExpr(assignNode->value, accesses);
+    accesses.writes.insert(assignNode->name);
+    break;
+  }
+  case NodeType::Show: {
+    for (ASTNode* value : static_cast<ShowNode*>(node)->values)
+      this->visitExpr(value, accesses);
+    break;
+  }
+  default:
+    this->visitExpr(node, accesses);
+    break;
+  }
+}
+
+void ParallelChecker::visitExpr(ASTNode* node, Accesses& accesses) {
+  // Expressions can be very deep, so they are walked with an explicit stack.
+  std::vector<ASTNode*> pending{node};
+
+  while (!pending.empty()) {
+    ASTNode* current = pending.back();
+    pending.pop_back();
+
+    switch (current->type) {
+    case NodeType::Variable:
+      accesses.reads.insert(static_cast<VariableNode*>(current)->name);
+      break;
+    case NodeType::BinaryOp: {
+      BinaryOpNode* binNode = static_cast<BinaryOpNode*>(current);
+      pending.push_back(binNode->left);
+      pending.push_back(binNode->right);
+      break;
+    }
+    case NodeType::BuiltinCall: {
+      std::vector<ASTNode*>& arguments = static_cast<BuiltinCallNode*>(current)->arguments;
+      pending.insert(pending.end(), arguments.begin(), arguments.end());
+      break;
+    }
+    default:
+      break;
+    }
+  }
+}
+
+void ParallelChecker::checkParallel(ASTNode* node) {
+  std::vector<ASTNode*> items =
+      static_cast<ProcedureBodyNode*>(static_cast<ParallelNode*>(node)->body)->getItems();
+
+  // Only procedure calls can run in parallel.
+  for (ASTNode* item : items) {
+    if (item->type != NodeType::ProcedureCall) {
+      logsys::get()->error("Parallel blocks can only contain procedure calls, found {}",
+                           getNodeType(item->type));
+      throw std::runtime_error("Parallel blocks can only contain procedure calls");
+    }
+  }
+
+  // A global written by one call can not be accessed by any other call of the block.
+  for (size_t i = 0; i < items.size(); i++) {
+    const std::string& name = static_cast<ProcedureCallNode*>(items[i])->name;
+    const Accesses* accesses = this->getProcedureAccesses(name);
+    if (!accesses)
+      continue;
+
+    for (size_t j = 0; j < items.size(); j++) {
+      if (i == j)
+        continue;
+      const std::string& otherName = static_cast<ProcedureCallNode*>(items[j])->name;
+      const Accesses* other = this->getProcedureAccesses(otherName);
+      if (!other)
+        continue;
+
+      for (const std::string& global : accesses->writes) {
+        if (other->writes.count(global) || other->reads.count(global)) {
+          logsys::get()->error("Procedures {} and {} access global {} in the same parallel block "
+                               "and {} writes it",
+                               name, otherName, global, name);
+          throw std::runtime_error("Conflicting global access in parallel block");
+        }
+      }
+    }
+  }
+}
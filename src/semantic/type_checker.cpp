@@ -0,0 +1,177 @@
+#include "semantic/type_checker.h"
+
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "logging.h"
+#include "semantic/builtins.h"
+
+void TypeChecker::check(ASTNode* rootNode) {
+  if (!rootNode) {
+    logsys::get()->error("No code provided to the type checker");
+    throw std::runtime_error("No code provided to the type checker");
+  }
+
+  // Variables can be read before the line that assigns them (e.g. in a procedure), so passes are
+  // repeated until no variable type widens. Types only grow, so this ends after a few passes.
+  do {
+    this->changed = false;
+    this->unknownVariable.clear();
+    this->visit(rootNode);
+  } while (this->changed);
+
+  if (!this->unknownVariable.empty()) {
+    logsys::get()->error("Variable {} is read but never assigned", this->unknownVariable);
+    throw std::runtime_error("Variable is read but never assigned");
+  }
+}
+
+void TypeChecker::checkItem(ASTNode* node) {
+  this->incremental = true;
+  this->unknownVariable.clear();
+  this->visit(node);
+
+  if (!this->unknownVariable.empty()) {
+    logsys::get()->error("Variable {} is read before being assigned", this->unknownVariable);
+    throw std::runtime_error("Variable is read before being assigned");
+  }
+}
+
+ValueType TypeChecker::getVariableType(const std::string& name) const {
+  auto it = this->variableTypeTable.find(name);
+  return it == this->variableTypeTable.end() ? ValueType::Unknown : it->second;
+}
+
+void TypeChecker::declareVariable(const std::string& name, ValueType type) {
+  this->variableTypeTable[name] = type;
+  this->fixedVariables.insert(name);
+}
+
+void TypeChecker::visit(ASTNode* node) {
+  switch (node->type) {
+  case NodeType::Program: {
+    for (ASTNode* child : static_cast<ProgramNode*>(node)->getItems())
+      this->visit(child);
+    break;
+  }
+  case NodeType::ProcedureBody: {
+    for (ASTNode* child : static_cast<ProcedureBodyNode*>(node)->getItems())
+      this->visit(child);
+    break;
+  }
+  case NodeType::Procedure: {
+    this->visit(static_cast<ProcedureNode*>(node)->body);
+    break;
+  }
+  case NodeType::ProcedureCall:
+    break;
+  case NodeType::Parallel: {
+    this->visit(static_cast<ParallelNode*>(node)->body);
+    break;
+  }
+  case NodeType::Show: {
+    for (ASTNode* value : static_cast<ShowNode*>(node)->values)
+      this->visitExpr(value);
+    break;
+  }
+  case NodeType::Assignment: {
+    AssignmentNode* assignNode = static_cast<AssignmentNode*>(node);
+    ValueType valueType = this->visitExpr(assignNode->value);
+
+    // Widen the variable to hold the assigned value.
+    ValueType oldType = this->getVariableType(assignNode->name);
+    bool fixed = (this->incremental && oldType != ValueType::Unknown) ||
+                 this->fixedVariables.count(assignNode->name) > 0;
+    ValueType newType = fixed ? oldType : joinValueTypes(oldType, valueType);
+    if (newType != oldType) {
+      this->variableTypeTable[assignNode->name] = newType;
+      this->changed = true;
+    }
+    assignNode->valueType = newType;
+    break;
+  }
+  default:
+    this->visitExpr(node);
+    break;
+  }
+}
+
+ValueType TypeChecker::visitExpr(ASTNode* rootNode) {
+  // Post-order walk with an explicit stack so that deep expressions do not overflow the call stack.
+  // A node is pushed twice: first to schedule its operands and then to take their types.
+  std::vector<std::pair<ASTNode*, bool>> pending{{rootNode, false}};
+
+  while (!pending.empty()) {
+    auto [node, operandsVisited] = pending.back();
+
+    if (!operandsVisited) {
+      pending.back().second = true;
+      std::vector<ASTNode*> operands;
+
+      switch (node->type) {
+      case NodeType::Number:
+      case NodeType::Integer:
+      case NodeType::Variable:
+        break;
+      case NodeType::BinaryOp: {
+        BinaryOpNode* binNode = static_cast<BinaryOpNode*>(node);
+        operands = {binNode->left, binNode->right};
+        break;
+      }
+      case NodeType::BuiltinCall: {
+        BuiltinCallNode* callNode = static_cast<BuiltinCallNode*>(node);
+        const BuiltinInfo* builtin = findBuiltin(callNode->name);
+        if (!builtin) {
+          logsys::get()->error("Unknown function {}", callNode->name);
+          throw std::runtime_error("Unknown function");
+        }
+        if (callNode->arguments.size() != builtin->arity) {
+          logsys::get()->error("Function {} expects {} arguments but got {}", callNode->name,
+                               builtin->arity, callNode->arguments.size());
+          throw std::runtime_error("Wrong number of arguments in function call");
+        }
+        operands = callNode->arguments;
+        break;
+      }
+      default:
+        logsys::get()->error("Type checking for type {} not supported.", getNodeType(node->type));
+        throw std::runtime_error("Type checking for this type of node not supported");
+      }
+
+      for (auto it = operands.rbegin(); it != operands.rend(); ++it)
+        pending.emplace_back(*it, false);
+      continue;
+    }
+
+    pending.pop_back();
+
+    switch (node->type) {
+    case NodeType::Variable: {
+      VariableNode* varNode = static_cast<VariableNode*>(node);
+      varNode->valueType = this->getVariableType(varNode->name);
+      if (varNode->valueType == ValueType::Unknown)
+        this->unknownVariable = varNode->name;
+      break;
+    }
+    case NodeType::BinaryOp: {
+      BinaryOpNode* binNode = static_cast<BinaryOpNode*>(node);
+      binNode->valueType = joinValueTypes(binNode->left->valueType, binNode->right->valueType);
+      break;
+    }
+    case NodeType::BuiltinCall: {
+      BuiltinCallNode* callNode = static_cast<BuiltinCallNode*>(node);
+      ValueType argumentsType = ValueType::Unknown;
+      for (ASTNode* argument : callNode->arguments)
+        argumentsType = joinValueTypes(argumentsType, argument->valueType);
+      callNode->valueType = getBuiltinResultType(*findBuiltin(callNode->name), argumentsType);
+      break;
+    }
+    default:
+      // Literals already know their type.
+      break;
+    }
+  }
+
+  return rootNode->valueType;
+}
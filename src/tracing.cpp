@@ -0,0 +1,91 @@
+#include "tracing.h"
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "logging.h"
+
+namespace {
+
+// One complete ("X") event of the Chrome trace format. Times are in microseconds.
+struct TraceEvent {
+  const char* name;
+  int64_t start;
+  int64_t duration;
+  size_t threadId;
+};
+
+std::atomic<bool> g_enabled{false};
+std::mutex g_eventsMutex;
+std::vector<TraceEvent> g_events;
+// Reference point of all timestamps.
+const std::chrono::steady_clock::time_point g_epoch = std::chrono::steady_clock::now();
+
+int64_t toMicroseconds(std::chrono::steady_clock::duration duration) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+}
+
+} // namespace
+
+namespace tracing {
+
+void enable() { g_enabled.store(true, std::memory_order_relaxed); }
+
+void disable() { g_enabled.store(false, std::memory_order_relaxed); }
+
+bool isEnabled() { return g_enabled.load(std::memory_order_relaxed); }
+
+void clear() {
+  std::lock_guard<std::mutex> lock(g_eventsMutex);
+  g_events.clear();
+}
+
+size_t getEventCount() {
+  std::lock_guard<std::mutex> lock(g_eventsMutex);
+  return g_events.size();
+}
+
+void writeChromeTrace(const std::string& fileName) {
+  std::ofstream file(fileName);
+  if (!file) {
+    logsys::get()->error("Could not open trace file {}", fileName);
+    throw std::runtime_error("Error writing trace file");
+  }
+
+  std::lock_guard<std::mutex> lock(g_eventsMutex);
+
+  file << "{\"traceEvents\":[";
+  for (size_t i = 0; i < g_events.size(); i++) {
+    const TraceEvent& event = g_events[i];
+    file << (i ? ",\n" : "\n") << "{\"name\":\"" << event.name
+         << "\",\"cat\":\"hebe\",\"ph\":\"X\",\"ts\":" << event.start
+         << ",\"dur\":" << event.duration << ",\"pid\":1,\"tid\":" << event.threadId << "}";
+  }
+  file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+}
+
+Scope::Scope(const char* name) : name(name), active(isEnabled()) {
+  if (this->active)
+    this->start = std::chrono::steady_clock::now();
+}
+
+Scope::~Scope() {
+  if (!this->active)
+    return;
+
+  std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+  TraceEvent event{this->name, toMicroseconds(this->start - g_epoch),
+                   toMicroseconds(end - this->start),
+                   std::hash<std::thread::id>{}(std::this_thread::get_id())};
+
+  std::lock_guard<std::mutex> lock(g_eventsMutex);
+  g_events.push_back(event);
+}
+
+} // namespace tracing
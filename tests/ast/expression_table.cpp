@@ -0,0 +1,73 @@
+#include <gtest/gtest.h>
+
+#include "ast/ast.h"
+#include "ast/expression_table.h"
+
+TEST(ExpressionTable, equal_expressions_are_shared) {
+  ExpressionTable table;
+  auto product = [&table] {
+    return table.intern(new BinaryOpNode('*', table.intern(new VariableNode("a")),
+                                         table.intern(new VariableNode("b"))));
+  };
+
+  ASTNode* first = product();
+  ASTNode* second = product();
+  ASTNode* sum = table.intern(new BinaryOpNode('+', first, second));
+
+  // The sum points twice to a * b, which points once to a and b.
+  EXPECT_EQ(first, second);
+  EXPECT_EQ(first->references, 2u);
+  EXPECT_EQ(static_cast<BinaryOpNode*>(first)->left->references, 1u);
+  EXPECT_EQ(table.size(), 4u);
+
+  // The program frees the shared product once, with the last reference.
+  ProgramNode program;
+  program.append(new AssignmentNode("x", sum));
+  table.clear();
+}
+
+TEST(ExpressionTable, different_literals_are_not_shared) {
+  ExpressionTable table;
+
+  ASTNode* f64 = table.intern(new NumberNode(1.0));
+  ASTNode* f32 = table.intern(new NumberNode(1.0, ValueType::F32));
+  ASTNode* negativeZero = table.intern(new NumberNode(-0.0));
+  ASTNode* zero = table.intern(new NumberNode(0.0));
+  ASTNode* integer = table.intern(new IntegerNode(1));
+
+  EXPECT_NE(f64, f32);
+  EXPECT_NE(negativeZero, zero);
+  EXPECT_EQ(table.intern(new IntegerNode(1)), integer);
+
+  ASTNode* sqrtCall = table.intern(new BuiltinCallNode("sqrt", {integer}));
+  ASTNode* absCall = table.intern(new BuiltinCallNode("abs", {integer}));
+  EXPECT_NE(sqrtCall, absCall);
+
+  ProgramNode program;
+  for (ASTNode* node : {f64, f32, negativeZero, zero, sqrtCall, absCall})
+    program.append(node);
+  table.clear();
+}
+
+TEST(ExpressionTable, released_nodes_leave_the_table) {
+  ExpressionTable table;
+
+  ASTNode* variable = table.intern(new VariableNode("a"));
+  table.release(variable);
+  EXPECT_EQ(table.size(), 0u);
+
+  // A new node with the same key is interned again.
+  ASTNode* again = table.intern(new VariableNode("a"));
+  EXPECT_EQ(again->references, 1u);
+  EXPECT_EQ(table.size(), 1u);
+  table.release(again);
+}
+
+TEST(ExpressionTable, statements_are_not_shared) {
+  ExpressionTable table;
+  ASTNode* call = new ProcedureCallNode("p");
+
+  EXPECT_EQ(table.intern(call), call);
+  EXPECT_EQ(table.size(), 0u);
+  delete call;
+}
@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/Instructions.h>
+
+#include "ast/ast.h"
+#include "ast/expression_table.h"
+#include "compiler.h"
+
+namespace {
+size_t countInstructions(llvm::Function* function, unsigned opcode) {
+  size_t count = 0;
+  for (llvm::BasicBlock& block : *function)
+    for (llvm::Instruction& inst : block)
+      count += inst.getOpcode() == opcode;
+  return count;
+}
+
+ASTNode* product(ExpressionTable& table) {
+  return table.intern(new BinaryOpNode('*', table.intern(new VariableNode("a")),
+                                       table.intern(new VariableNode("b"))));
+}
+} // namespace
+
+TEST(Compiler_common_subexpressions, shared_expressions_are_generated_once) {
+  // save 1 in a
+  // save 2 in b
+  // save a * b + a * b in x
+  // save a * b in y
+  ExpressionTable table;
+  ProgramNode program;
+  program.append(new AssignmentNode("a", table.intern(new IntegerNode(1))));
+  program.append(new AssignmentNode("b", table.intern(new IntegerNode(2))));
+  program.append(
+      new AssignmentNode("x", table.intern(new BinaryOpNode('+', product(table), product(table)))));
+  program.append(new AssignmentNode("y", product(table)));
+  table.clear();
+
+  Compiler c(&program);
+  c.generateCode();
+
+  llvm::Function* run = c.module->getFunction("run");
+  EXPECT_EQ(countInstructions(run, llvm::Instruction::Mul), 1u);
+  // a and b are loaded once, the stores to x and y do not change them, and ret at the end.
+  EXPECT_EQ(countInstructions(run, llvm::Instruction::Load), 3u);
+}
+
+TEST(Compiler_common_subexpressions, assignments_and_calls_invalidate_values) {
+  // create touch
+  //     save 3 in b
+  // done
+  // save 1 in a
+  // save 2 in b
+  // save a * b in x
+  // save 5 in a
+  // save a * b in y
+  // touch
+  // save a * b in z
+  ExpressionTable table;
+  ProcedureBodyNode* body = new ProcedureBodyNode();
+  body->append(new AssignmentNode("b", table.intern(new IntegerNode(3))));
+
+  ProgramNode program;
+  program.append(new ProcedureNode("touch", body));
+  program.append(new AssignmentNode("a", table.intern(new IntegerNode(1))));
+  program.append(new AssignmentNode("b", table.intern(new IntegerNode(2))));
+  program.append(new AssignmentNode("x", product(table)));
+  program.append(new AssignmentNode("a", table.intern(new IntegerNode(5))));
+  program.append(new AssignmentNode("y", product(table)));
+  program.append(new ProcedureCallNode("touch"));
+  program.append(new AssignmentNode("z", product(table)));
+  table.clear();
+
+  Compiler c(&program);
+  c.generateCode();
+
+  // The product is recomputed after a changes and after the call, which could change b.
+  llvm::Function* run = c.module->getFunction("run");
+  EXPECT_EQ(countInstructions(run, llvm::Instruction::Mul), 3u);
+
+  // Values of run are not used inside the procedure.
+  EXPECT_EQ(countInstructions(c.module->getFunction("touch"), llvm::Instruction::Mul), 0u);
+}
@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+#include <llvm/IR/DebugInfoMetadata.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/Verifier.h>
+#include <string>
+#include <unistd.h>
+
+#include "ast/ast.h"
+#include "compiler.h"
+#include "helpers.h"
+#include "jit/perf_map_listener.h"
+#include "options.h"
+
+TEST(Compiler_debug_info, statements_have_source_lines) {
+  ProgramNode* program = new ProgramNode();
+  ProcedureBodyNode* body = new ProcedureBodyNode();
+  body->append(new AssignmentNode(
+                   "x", new BinaryOpNode('+', new VariableNode("x"), new IntegerNode(1))),
+               3);
+  program->append(new AssignmentNode("x", new IntegerNode(1)), 1);
+  program->append(new ProcedureNode("step", body, 2), 2);
+  program->append(new ProcedureCallNode("step"), 5);
+
+  CompilerOptions options;
+  options.inputFile = "program.hebe";
+  options.debugInfo = true;
+  Compiler c(program, options);
+  c.generateCode();
+
+  EXPECT_FALSE(llvm::verifyModule(*c.module, &llvm::errs()));
+
+  // Every function has its own subprogram starting at its line.
+  llvm::Function* run = c.module->getFunction("run");
+  llvm::Function* step = c.module->getFunction("step");
+  ASSERT_NE(run->getSubprogram(), nullptr);
+  ASSERT_NE(step->getSubprogram(), nullptr);
+  EXPECT_EQ(step->getSubprogram()->getLine(), 2u);
+  EXPECT_EQ(step->getSubprogram()->getFilename(), "program.hebe");
+
+  // Instructions carry the line of the statement they come from.
+  bool foundCall = false;
+  for (llvm::Instruction& inst : run->getEntryBlock()) {
+    if (llvm::isa<llvm::CallInst>(inst)) {
+      ASSERT_TRUE(inst.getDebugLoc());
+      EXPECT_EQ(inst.getDebugLoc().getLine(), 5u);
+      foundCall = true;
+    }
+  }
+  EXPECT_TRUE(foundCall);
+
+  for (llvm::Instruction& inst : step->getEntryBlock()) {
+    if (llvm::isa<llvm::StoreInst>(inst) && inst.getOperand(1) == c.module->getNamedGlobal("x")) {
+      EXPECT_EQ(inst.getDebugLoc().getLine(), 3u);
+    }
+  }
+
+  delete program;
+}
+
+TEST(Compiler_debug_info, library_procedures_keep_their_file) {
+  // Library built from two files, whose lines both start at 1.
+  ProgramNode library;
+  ProcedureNode* first = createWriter("first", "a", new IntegerNode(1));
+  first->line = 1;
+  library.append(first, 1);
+  ProcedureNode* second = createWriter("second", "b", new IntegerNode(2));
+  second->line = 1;
+  second->file = "second.hebe";
+  library.append(second, 1);
+
+  CompilerOptions options;
+  options.inputFile = "first.hebe";
+  options.libraryInputFiles = {"second.hebe"};
+  options.libraryOutput = "library.bc";
+  options.debugInfo = true;
+  Compiler c(&library, options);
+  c.generateLibrary();
+
+  EXPECT_FALSE(llvm::verifyModule(*c.module, &llvm::errs()));
+  llvm::DISubprogram* firstProgram = c.module->getFunction("first")->getSubprogram();
+  llvm::DISubprogram* secondProgram = c.module->getFunction("second")->getSubprogram();
+  ASSERT_NE(firstProgram, nullptr);
+  ASSERT_NE(secondProgram, nullptr);
+  EXPECT_EQ(firstProgram->getFilename(), "first.hebe");
+  EXPECT_EQ(secondProgram->getFilename(), "second.hebe");
+  EXPECT_EQ(secondProgram->getLine(), 1u);
+}
+
+TEST(Compiler_debug_info, disabled_by_default) {
+  ProgramNode program;
+  program.append(new AssignmentNode("ret", new IntegerNode(7)));
+
+  Compiler c(&program, CompilerOptions());
+  c.generateCode();
+
+  EXPECT_EQ(c.module->getFunction("run")->getSubprogram(), nullptr);
+  EXPECT_EQ(c.module->getModuleFlag("Debug Info Version"), nullptr);
+}
+
+TEST(PerfMapListener, entry_format) {
+  EXPECT_EQ(PerfMapListener::formatEntry(0x7f0012340000, 0x2a, "run"), "7f0012340000 2a run\n");
+
+  PerfMapListener listener;
+  EXPECT_EQ(listener.getPath(), "/tmp/perf-" + std::to_string(getpid()) + ".map");
+}
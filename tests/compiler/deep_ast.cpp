@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+#include <llvm/IR/Function.h>
+#include <spdlog/spdlog.h>
+#include <string>
+
+#include "ast/ast.h"
+#include "compiler.h"
+#include "logging.h"
+
+typedef struct yy_buffer_state* YY_BUFFER_STATE;
+extern YY_BUFFER_STATE yy_scan_string(const char* str);
+extern void yy_delete_buffer(YY_BUFFER_STATE buffer);
+extern void yy_switch_to_buffer(YY_BUFFER_STATE new_buffer);
+extern int yyparse();
+
+extern ASTNode* root;
+
+namespace {
+// Number of terms of the generated expressions. Deep enough to overflow the stack if any pass
+// recursed once per tree level.
+constexpr int termCount = 1000000;
+} // namespace
+
+TEST(Compiler_deep_ast, long_left_associative_expression) {
+  // save 1 + 1 + ... + 1 in ret builds a left spine one million levels deep.
+  std::string testCode = "save 1";
+  testCode.reserve(termCount * 4 + 16);
+  for (int i = 1; i < termCount; i++)
+    testCode += " + 1";
+  testCode += " in ret\n";
+
+  YY_BUFFER_STATE buffer = yy_scan_string(testCode.c_str());
+  yy_switch_to_buffer(buffer);
+  int result = yyparse();
+  yy_delete_buffer(buffer);
+  ASSERT_EQ(result, 0);
+
+  Compiler c(root);
+  c.generateCode();
+
+  // One add per operator.
+  EXPECT_GE(c.module->getFunction("run")->getInstructionCount(), termCount - 1);
+
+  // The tree is walked but nothing is formatted.
+  logsys::get()->set_level(spdlog::level::off);
+  c.printNodeTree();
+  logsys::get()->set_level(spdlog::level::info);
+
+  delete root;
+  root = nullptr;
+}
+
+TEST(Compiler_deep_ast, deep_right_nested_expression) {
+  // 1 - (1 - (1 - ...)) built directly, the parser would need a stack as deep as the tree.
+  ASTNode* expression = new IntegerNode(1);
+  for (int i = 1; i < termCount; i++)
+    expression = new BinaryOpNode('-', new IntegerNode(1), expression);
+
+  ProgramNode program;
+  program.append(new AssignmentNode("ret", expression));
+
+  Compiler c(&program);
+  c.generateCode();
+
+  EXPECT_GE(c.module->getFunction("run")->getInstructionCount(), termCount - 1);
+}
+
+TEST(Compiler_deep_ast, deep_shared_expression) {
+  // save x + x + ... + x in a, then in b. Every level of the spine is shared by both assignments,
+  // so caching must not walk the tree below each level again.
+  std::string expression = "x";
+  expression.reserve(termCount * 4);
+  for (int i = 1; i < termCount; i++)
+    expression += " + x";
+  std::string testCode =
+      "save 1 in x\nsave " + expression + " in a\nsave " + expression + " in b\n";
+
+  YY_BUFFER_STATE buffer = yy_scan_string(testCode.c_str());
+  yy_switch_to_buffer(buffer);
+  int result = yyparse();
+  yy_delete_buffer(buffer);
+  ASSERT_EQ(result, 0);
+
+  Compiler c(root);
+  c.generateCode();
+
+  // b reuses the value of a instead of generating the additions again.
+  unsigned instructions = c.module->getFunction("run")->getInstructionCount();
+  EXPECT_GE(instructions, termCount - 1);
+  EXPECT_LT(instructions, 2 * termCount);
+
+  delete root;
+  root = nullptr;
+}
@@ -0,0 +1,54 @@
+#include <gtest/gtest.h>
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/Instruction.h>
+#include <llvm/IR/Metadata.h>
+#include <llvm/Support/Casting.h>
+
+#include "ast/ast.h"
+#include "compiler.h"
+#include "options.h"
+
+TEST(Compiler_fast_math, flags_are_set_on_operations) {
+  CompilerOptions options;
+  options.fpContract = true;
+  options.fpReassoc = true;
+
+  BinaryOpNode binOpNode('+', new NumberNode(1.0), new NumberNode(2.0));
+  Compiler c(nullptr, options);
+  llvm::Instruction* add = llvm::dyn_cast<llvm::Instruction>(c.codegenExpr(&binOpNode));
+
+  // Only the selected flags are set.
+  ASSERT_NE(add, nullptr);
+  EXPECT_TRUE(add->hasAllowContract());
+  EXPECT_TRUE(add->hasAllowReassoc());
+  EXPECT_FALSE(add->hasNoNaNs());
+  EXPECT_FALSE(add->hasNoInfs());
+
+  // The module records how it was compiled.
+  llvm::Metadata* flagValue = c.module->getModuleFlag(fastMathModuleFlag);
+  llvm::ConstantInt* flag = llvm::mdconst::extract_or_null<llvm::ConstantInt>(flagValue);
+  ASSERT_NE(flag, nullptr);
+  EXPECT_NE(flag->getZExtValue(), 0u);
+}
+
+TEST(Compiler_fast_math, strict_by_default) {
+  BinaryOpNode binOpNode('*', new NumberNode(1.0), new NumberNode(2.0));
+  Compiler c = Compiler();
+  llvm::Instruction* mul = llvm::dyn_cast<llvm::Instruction>(c.codegenExpr(&binOpNode));
+
+  ASSERT_NE(mul, nullptr);
+  EXPECT_FALSE(mul->getFastMathFlags().any());
+  EXPECT_EQ(c.module->getModuleFlag(fastMathModuleFlag), nullptr);
+
+  // With --fast-math every flag is set and the functions are marked.
+  CompilerOptions options;
+  options.fastMath = true;
+  ProgramNode program;
+  program.append(new AssignmentNode("ret", new BinaryOpNode('/', new NumberNode(1.0),
+                                                            new NumberNode(3.0))));
+  Compiler fast(&program, options);
+  fast.generateCode();
+
+  EXPECT_TRUE(fast.builder->getFastMathFlags().isFast());
+  EXPECT_TRUE(fast.module->getFunction("run")->hasFnAttribute("unsafe-fp-math"));
+}
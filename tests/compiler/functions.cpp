@@ -1,13 +1,18 @@
+#include <cstdint>
 #include <cstdio>
 #include <gtest/gtest.h>
+#include <llvm/IR/BasicBlock.h>
 #include <llvm/IR/Constant.h>
 #include <llvm/IR/Constants.h>
 #include <llvm/IR/GlobalVariable.h>
 #include <llvm/IR/InstrTypes.h>
 #include <llvm/IR/Instruction.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/IntrinsicInst.h>
 #include <llvm/IR/Type.h>
 #include <llvm/IR/Value.h>
 #include <llvm/Support/Casting.h>
+#include <limits>
 #include <regex>
 #include <spdlog/sinks/ostream_sink.h>
 #include <spdlog/spdlog.h>
@@ -39,6 +44,9 @@ TEST(Compiler, print_node_tree_with_no_nodes) {
 }
 
 TEST(Compiler, print_node_tree_with_number_node) {
+#if SPDLOG_ACTIVE_LEVEL > SPDLOG_LEVEL_DEBUG
+  GTEST_SKIP() << "Debug messages are removed from this build";
+#endif
 
   // Clear the logger sinks just in case.
   logsys::get()->sinks().clear();
@@ -51,8 +59,8 @@ TEST(Compiler, print_node_tree_with_number_node) {
   // Add the sink to the logger.
   logsys::get()->sinks().push_back(test_sink);
 
-  // Ensure level is set to capture the info calls
-  logsys::get()->set_level(spdlog::level::info);
+  // Ensure level is set to capture the debug calls
+  logsys::get()->set_level(spdlog::level::debug);
 
   // Begin the actual testing.
   NumberNode num(0.0);
@@ -60,13 +68,14 @@ TEST(Compiler, print_node_tree_with_number_node) {
   c.printNodeTree(&num);
 
   std::regex pattern("\\[\\d{4}-\\d{2}-\\d{2} \\d{2}:\\d{2}:\\d{2}\\.\\d{3}\\] "
-                     "\\[info\\](\\s*|\t+)Number: \\d+.?\\d*\n?");
+                     "\\[debug\\](\\s*|\t+)Number: \\d+.?\\d*\n?");
 
   // Extract the captured string.
   std::string consoleOutput = captured_oss->str();
 
   // Clear again the sinks.
   logsys::get()->sinks().clear();
+  logsys::get()->set_level(spdlog::level::info);
 
   ASSERT_FALSE(consoleOutput.empty()) << "Logger captured nothing!";
   EXPECT_TRUE(std::regex_search(consoleOutput, pattern));
@@ -85,17 +94,149 @@ TEST(Compiler_codegen, number_node) {
     Compiler c = Compiler();
     llvm::Value* expression = c.codegenExpr(numberNodeAST);
 
-    // The expression should be of type Float.
-    EXPECT_TRUE(expression->getType()->isFloatTy());
+    // Number literals without suffix are f64.
+    EXPECT_TRUE(expression->getType()->isDoubleTy());
 
     // Check that the value of the returned expression matches the one originally used.
     llvm::ConstantFP* constantFloatPointExpression = llvm::dyn_cast<llvm::ConstantFP>(expression);
-    float floatValue = constantFloatPointExpression->getValueAPF().convertToFloat();
+    double doubleValue = constantFloatPointExpression->getValueAPF().convertToDouble();
+
+    EXPECT_DOUBLE_EQ(doubleValue, testValue);
+  }
+}
+
+TEST(Compiler_codegen, f32_number_node) {
+  NumberNode numberNode = NumberNode(1.5, ValueType::F32);
+
+  Compiler c = Compiler();
+  llvm::Value* expression = c.codegenExpr(&numberNode);
+
+  EXPECT_TRUE(expression->getType()->isFloatTy());
+  EXPECT_FLOAT_EQ(llvm::dyn_cast<llvm::ConstantFP>(expression)->getValueAPF().convertToFloat(),
+                  1.5f);
+}
+
+TEST(Compiler_codegen, integer_node) {
+  // Values that do not fit in a float or a double mantissa.
+  int64_t testValues[4] = {-9007199254740993, -1, 0, 9007199254740993};
+
+  for (int64_t testValue : testValues) {
+    IntegerNode integerNode = IntegerNode(testValue);
+
+    Compiler c = Compiler();
+    llvm::Value* expression = c.codegenExpr(&integerNode);
+
+    EXPECT_TRUE(expression->getType()->isIntegerTy(64));
+    EXPECT_EQ(llvm::dyn_cast<llvm::ConstantInt>(expression)->getSExtValue(), testValue);
+  }
+}
+
+TEST(Compiler_codegen, integer_binary_op_node) {
+  // Division selects its result around the sdiv, see integer_division_is_defined.
+  char opList[4] = {'+', '-', '*', '/'};
+  unsigned opcodes[4] = {llvm::Instruction::Add, llvm::Instruction::Sub, llvm::Instruction::Mul,
+                         llvm::Instruction::Select};
 
-    EXPECT_FLOAT_EQ(floatValue, testValue);
+  for (int i = 0; i < 4; i++) {
+    BinaryOpNode binOpNode = BinaryOpNode(opList[i], new IntegerNode(7), new IntegerNode(2));
+
+    Compiler c = Compiler();
+    llvm::Value* expression = c.codegenExpr(&binOpNode);
+
+    // Integer operations stay integer.
+    ASSERT_NE(expression, nullptr);
+    EXPECT_TRUE(expression->getType()->isIntegerTy(64));
+    EXPECT_EQ(llvm::dyn_cast<llvm::Instruction>(expression)->getOpcode(), opcodes[i]);
   }
 }
 
+TEST(Compiler_codegen, integer_division_is_defined) {
+  // save 7 / 0 in ret
+  ProgramNode byZero;
+  byZero.append(
+      new AssignmentNode("ret", new BinaryOpNode('/', new IntegerNode(7), new IntegerNode(0))));
+
+  Compiler zeroCompiler(&byZero);
+  zeroCompiler.generateCode();
+  EXPECT_EQ(zeroCompiler.runJIT(), 0);
+
+  // save -9223372036854775808 / -1 / -9223372036854775808 in ret
+  int64_t minimum = std::numeric_limits<int64_t>::min();
+  ProgramNode overflow;
+  overflow.append(new AssignmentNode(
+      "ret", new BinaryOpNode('/',
+                              new BinaryOpNode('/', new IntegerNode(minimum), new IntegerNode(-1)),
+                              new IntegerNode(minimum))));
+
+  // The quotient wraps around to the minimum value, so dividing it by the minimum gives 1.
+  Compiler overflowCompiler(&overflow);
+  overflowCompiler.generateCode();
+  EXPECT_EQ(overflowCompiler.runJIT(), 1);
+}
+
+TEST(Compiler_codegen, mixed_binary_op_node_converts_to_widest_type) {
+  BinaryOpNode binOpNode =
+      BinaryOpNode('+', new IntegerNode(1), new NumberNode(2.0, ValueType::F32));
+
+  Compiler c = Compiler();
+  llvm::Value* expression = c.codegenExpr(&binOpNode);
+
+  // The integer is converted with sitofp and the addition is done in f32.
+  ASSERT_NE(expression, nullptr);
+  EXPECT_TRUE(expression->getType()->isFloatTy());
+  llvm::Instruction* inst = llvm::dyn_cast<llvm::Instruction>(expression);
+  EXPECT_EQ(inst->getOpcode(), llvm::Instruction::FAdd);
+  EXPECT_TRUE(llvm::isa<llvm::SIToFPInst>(inst->getOperand(0)));
+}
+
+TEST(Compiler_codegen, builtin_call_node) {
+  Compiler c = Compiler();
+
+  // Floating point functions convert integer arguments to f64.
+  BuiltinCallNode sqrtNode("sqrt", {new IntegerNode(2)});
+  llvm::IntrinsicInst* sqrtCall =
+      llvm::dyn_cast<llvm::IntrinsicInst>(c.codegenExpr(&sqrtNode));
+  ASSERT_NE(sqrtCall, nullptr);
+  EXPECT_EQ(sqrtCall->getIntrinsicID(), llvm::Intrinsic::sqrt);
+  EXPECT_TRUE(sqrtCall->getType()->isDoubleTy());
+
+  // min and max of integers stay integer.
+  BuiltinCallNode maxNode("max", {new IntegerNode(1), new IntegerNode(2)});
+  llvm::IntrinsicInst* maxCall = llvm::dyn_cast<llvm::IntrinsicInst>(c.codegenExpr(&maxNode));
+  ASSERT_NE(maxCall, nullptr);
+  EXPECT_EQ(maxCall->getIntrinsicID(), llvm::Intrinsic::smax);
+  EXPECT_TRUE(maxCall->getType()->isIntegerTy(64));
+
+  // Mixed arguments use the widest type.
+  BuiltinCallNode fmaNode("fma", {new NumberNode(1.0, ValueType::F32), new IntegerNode(2),
+                                  new NumberNode(3.0, ValueType::F32)});
+  llvm::IntrinsicInst* fmaCall = llvm::dyn_cast<llvm::IntrinsicInst>(c.codegenExpr(&fmaNode));
+  ASSERT_NE(fmaCall, nullptr);
+  EXPECT_EQ(fmaCall->getIntrinsicID(), llvm::Intrinsic::fma);
+  EXPECT_TRUE(fmaCall->getType()->isFloatTy());
+}
+
+TEST(Compiler_codegen, show_node) {
+  ShowNode showNode({new IntegerNode(1), new NumberNode(2.0, ValueType::F32)});
+
+  Compiler c = Compiler();
+  llvm::Function* run = c.createFunction("run", c.createFunctionType(c.builder->getVoidTy()));
+  c.builder->SetInsertPoint(llvm::BasicBlock::Create(*c.context, "entry", run));
+  c.codegenExpr(&showNode);
+
+  // One runtime call per value. The last one ends the line.
+  std::vector<llvm::CallInst*> calls;
+  for (llvm::Instruction& inst : run->getEntryBlock())
+    if (llvm::CallInst* call = llvm::dyn_cast<llvm::CallInst>(&inst))
+      calls.push_back(call);
+
+  ASSERT_EQ(calls.size(), 2);
+  EXPECT_EQ(calls[0]->getCalledFunction()->getName(), "hebe_show_i64");
+  EXPECT_EQ(llvm::cast<llvm::ConstantInt>(calls[0]->getArgOperand(1))->getSExtValue(), ' ');
+  EXPECT_EQ(calls[1]->getCalledFunction()->getName(), "hebe_show_f32");
+  EXPECT_EQ(llvm::cast<llvm::ConstantInt>(calls[1]->getArgOperand(1))->getSExtValue(), '\n');
+}
+
 TEST(Compiler_codegen, binary_op_node) {
   // Create lists for the values to test (operations and numeric).
   char opList[4] = {'+', '-', '*', '/'};
@@ -121,8 +262,8 @@ TEST(Compiler_codegen, binary_op_node) {
         // Ensure the expression was correctly generated.
         ASSERT_NE(expression, nullptr);
 
-        // Ensure the expression returns a float type.
-        EXPECT_TRUE(expression->getType()->isFloatTy());
+        // Ensure the expression returns a double type.
+        EXPECT_TRUE(expression->getType()->isDoubleTy());
 
         // Ensure the expression is a binary operation.
         EXPECT_TRUE(llvm::isa<llvm::BinaryOperator>(expression));
@@ -185,3 +326,27 @@ TEST(Compiler_codegen, assignment_node) {
 
   SUCCEED();
 }
+
+TEST(Compiler_codegen, typed_program) {
+  // save 1 in counter
+  // save counter + 1.5 in counter
+  // save counter in total
+  // save 2 in index
+  ProgramNode program;
+  program.append(new AssignmentNode("counter", new IntegerNode(1)));
+  program.append(new AssignmentNode(
+      "counter", new BinaryOpNode('+', new VariableNode("counter"), new NumberNode(1.5))));
+  program.append(new AssignmentNode("total", new VariableNode("counter")));
+  program.append(new AssignmentNode("index", new IntegerNode(2)));
+
+  Compiler c(&program);
+  c.generateCode();
+
+  // counter receives an f64 so it is f64 from the first assignment on.
+  EXPECT_TRUE(c.getGlobalVariable("counter")->getValueType()->isDoubleTy());
+  EXPECT_TRUE(c.getGlobalVariable("total")->getValueType()->isDoubleTy());
+  EXPECT_TRUE(c.getGlobalVariable("index")->getValueType()->isIntegerTy(64));
+
+  // run always returns f64.
+  EXPECT_TRUE(c.module->getFunction("run")->getReturnType()->isDoubleTy());
+}
@@ -0,0 +1,68 @@
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/GlobalVariable.h>
+#include <string>
+
+#include "ast/ast.h"
+#include "compiler.h"
+#include "helpers.h"
+#include "library/library_index.h"
+#include "options.h"
+
+TEST(Compiler_libraries, only_called_procedures_are_linked) {
+  std::string path = "hebe_test_library.bc";
+
+  ProgramNode library;
+  library.append(createWriter("used", "counter", new IntegerNode(1)));
+  library.append(createWriter("unused", "other", new NumberNode(2.0)));
+
+  CompilerOptions libraryOptions;
+  libraryOptions.libraryOutput = path;
+  Compiler libraryCompiler(&library, libraryOptions);
+  libraryCompiler.generateLibrary();
+  libraryCompiler.writeLibrary(path);
+
+  ProgramNode program;
+  program.append(new ProcedureCallNode("used"));
+  program.append(new AssignmentNode("ret", new VariableNode("counter")));
+
+  CompilerOptions options;
+  options.libraries = {path};
+  Compiler c(&program, options);
+  c.generateCode();
+
+  std::remove(path.c_str());
+  std::remove((path + libraryIndexSuffix).c_str());
+
+  ASSERT_NE(c.module->getFunction("used"), nullptr);
+  EXPECT_FALSE(c.module->getFunction("used")->isDeclaration());
+  EXPECT_EQ(c.module->getFunction("unused"), nullptr);
+
+  // The library only declares its globals, the program defines them.
+  EXPECT_FALSE(c.module->getGlobalVariable("counter")->isDeclaration());
+  EXPECT_FALSE(c.module->getGlobalVariable("other")->isDeclaration());
+
+  EXPECT_EQ(c.runJIT(), 1);
+}
+
+TEST(Compiler_libraries, unused_library_is_not_read) {
+  // Only the index exists, the bitcode would fail to load.
+  std::string path = "hebe_test_missing_library.bc";
+  LibraryIndex index;
+  index.addGlobal("counter", ValueType::I64);
+  index.addProcedure({"increment", {"counter"}, {"counter"}});
+  index.writeToFile(path + libraryIndexSuffix);
+
+  ProgramNode program;
+  program.append(new AssignmentNode("ret", new IntegerNode(3)));
+
+  CompilerOptions options;
+  options.libraries = {path};
+  Compiler c(&program, options);
+  EXPECT_NO_THROW(c.generateCode());
+  std::remove((path + libraryIndexSuffix).c_str());
+
+  EXPECT_TRUE(c.usedLibraries.empty());
+  EXPECT_EQ(c.module->getFunction("increment"), nullptr);
+}
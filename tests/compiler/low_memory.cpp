@@ -0,0 +1,28 @@
+#include <gtest/gtest.h>
+#include <llvm/IR/Function.h>
+
+#include "ast/ast.h"
+#include "compiler.h"
+#include "memory_usage.h"
+#include "options.h"
+
+TEST(Compiler_low_memory, release_ast_after_code_generation) {
+  ProgramNode* program = new ProgramNode();
+  program->append(new AssignmentNode("ret", new IntegerNode(7)));
+
+  CompilerOptions options;
+  options.lowMemory = true;
+  Compiler c(program, options);
+  c.generateCode();
+  c.releaseAST();
+
+  // The generated code does not depend on the AST.
+  EXPECT_EQ(c.rootNode, nullptr);
+  EXPECT_NE(c.module->getFunction("run"), nullptr);
+  EXPECT_THROW(c.printNodeTree(), std::runtime_error);
+}
+
+TEST(MemoryUsage, resident_memory_is_reported) {
+  EXPECT_GT(getResidentMemory(), 0u);
+  trimHeap();
+}
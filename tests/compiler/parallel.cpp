@@ -0,0 +1,40 @@
+#include <gtest/gtest.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/Instructions.h>
+#include <string>
+#include <vector>
+
+#include "ast/ast.h"
+#include "compiler.h"
+
+TEST(Compiler_parallel, block_spawns_and_joins) {
+  // parallel
+  //     a
+  //     b
+  // done
+  ProcedureBodyNode* aBody = new ProcedureBodyNode();
+  aBody->append(new AssignmentNode("x", new IntegerNode(1)));
+  ProcedureBodyNode* bBody = new ProcedureBodyNode();
+  bBody->append(new AssignmentNode("y", new IntegerNode(2)));
+  ProcedureBodyNode* block = new ProcedureBodyNode();
+  block->append(new ProcedureCallNode("a"));
+  block->append(new ProcedureCallNode("b"));
+
+  ProgramNode program;
+  program.append(new ProcedureNode("a", aBody));
+  program.append(new ProcedureNode("b", bBody));
+  program.append(new ParallelNode(block));
+  program.append(new AssignmentNode("ret", new VariableNode("x")));
+
+  Compiler c(&program);
+  c.generateCode();
+
+  std::vector<std::string> calls;
+  for (llvm::Instruction& inst : c.module->getFunction("run")->getEntryBlock())
+    if (llvm::CallInst* call = llvm::dyn_cast<llvm::CallInst>(&inst))
+      calls.push_back(call->getCalledFunction()->getName().str());
+
+  std::vector<std::string> expected = {"hebe_parallel_begin", "hebe_parallel_spawn",
+                                       "hebe_parallel_spawn", "hebe_parallel_join"};
+  EXPECT_EQ(calls, expected);
+}
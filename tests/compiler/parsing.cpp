@@ -6,6 +6,7 @@ extern YY_BUFFER_STATE yy_scan_string(const char* str);
 extern void yy_delete_buffer(YY_BUFFER_STATE buffer);
 extern void yy_switch_to_buffer(YY_BUFFER_STATE new_buffer);
 extern int yyparse();
+extern int yylineno;
 
 extern ASTNode* root;
 
@@ -30,4 +31,192 @@ TEST(Parsing, number_node_parsing) {
 
   // The program consists only of one item.
   EXPECT_EQ(program->getItems().size(), 1);
-}
\ No newline at end of file
+}
+TEST(Parsing, typed_literals_and_variables) {
+  std::string testCode = "save 1 in i\nsave 1.5f in f\nsave i + 2.5 in d\nmy_procedure\n";
+
+  YY_BUFFER_STATE buffer = yy_scan_string(testCode.c_str());
+  yy_switch_to_buffer(buffer);
+  int result = yyparse();
+  yy_delete_buffer(buffer);
+
+  EXPECT_EQ(result, 0);
+
+  std::vector<ASTNode*> items = static_cast<ProgramNode*>(root)->getItems();
+  ASSERT_EQ(items.size(), 4);
+
+  // Integer and f32 literals.
+  EXPECT_EQ(static_cast<AssignmentNode*>(items[0])->value->type, NodeType::Integer);
+  EXPECT_EQ(static_cast<AssignmentNode*>(items[1])->value->valueType, ValueType::F32);
+
+  // A word inside an expression reads a variable.
+  BinaryOpNode* sum = static_cast<BinaryOpNode*>(static_cast<AssignmentNode*>(items[2])->value);
+  EXPECT_EQ(sum->left->type, NodeType::Variable);
+
+  // A word alone in a line calls a procedure.
+  EXPECT_EQ(items[3]->type, NodeType::ProcedureCall);
+}
+
+TEST(Parsing, builtin_calls) {
+  std::string testCode = "save fma(x, 2.0, sqrt(y)) + 1 in z\n";
+
+  YY_BUFFER_STATE buffer = yy_scan_string(testCode.c_str());
+  yy_switch_to_buffer(buffer);
+  int result = yyparse();
+  yy_delete_buffer(buffer);
+
+  EXPECT_EQ(result, 0);
+
+  std::vector<ASTNode*> items = static_cast<ProgramNode*>(root)->getItems();
+  ASSERT_EQ(items.size(), 1);
+
+  BinaryOpNode* sum = static_cast<BinaryOpNode*>(static_cast<AssignmentNode*>(items[0])->value);
+  ASSERT_EQ(sum->left->type, NodeType::BuiltinCall);
+
+  BuiltinCallNode* fma = static_cast<BuiltinCallNode*>(sum->left);
+  EXPECT_EQ(fma->name, "fma");
+  ASSERT_EQ(fma->arguments.size(), 3);
+  EXPECT_EQ(fma->arguments[0]->type, NodeType::Variable);
+  EXPECT_EQ(fma->arguments[2]->type, NodeType::BuiltinCall);
+}
+
+TEST(Parsing, show_statement) {
+  std::string testCode = "show x -> x * 2 -> sqrt(2.0)\n";
+
+  YY_BUFFER_STATE buffer = yy_scan_string(testCode.c_str());
+  yy_switch_to_buffer(buffer);
+  int result = yyparse();
+  yy_delete_buffer(buffer);
+
+  EXPECT_EQ(result, 0);
+
+  std::vector<ASTNode*> items = static_cast<ProgramNode*>(root)->getItems();
+  ASSERT_EQ(items.size(), 1);
+  ASSERT_EQ(items[0]->type, NodeType::Show);
+
+  ShowNode* show = static_cast<ShowNode*>(items[0]);
+  ASSERT_EQ(show->values.size(), 3);
+  EXPECT_EQ(show->values[0]->type, NodeType::Variable);
+  EXPECT_EQ(show->values[1]->type, NodeType::BinaryOp);
+  EXPECT_EQ(show->values[2]->type, NodeType::BuiltinCall);
+}
+
+TEST(Parsing, parallel_block) {
+  std::string testCode = "parallel\n    first\n    second\ndone\n";
+
+  YY_BUFFER_STATE buffer = yy_scan_string(testCode.c_str());
+  yy_switch_to_buffer(buffer);
+  int result = yyparse();
+  yy_delete_buffer(buffer);
+
+  EXPECT_EQ(result, 0);
+
+  std::vector<ASTNode*> items = static_cast<ProgramNode*>(root)->getItems();
+  ASSERT_EQ(items.size(), 1);
+  ASSERT_EQ(items[0]->type, NodeType::Parallel);
+
+  ParallelNode* parallel = static_cast<ParallelNode*>(items[0]);
+  std::vector<ASTNode*> calls = static_cast<ProcedureBodyNode*>(parallel->body)->getItems();
+  ASSERT_EQ(calls.size(), 2);
+  EXPECT_EQ(calls[0]->type, NodeType::ProcedureCall);
+  EXPECT_EQ(static_cast<ProcedureCallNode*>(calls[1])->name, "second");
+}
+
+TEST(Parsing, statements_record_their_line) {
+  std::string testCode = "save 1 in x\n\ncreate step\n    save x + 1 in x\ndone\nstep\n";
+
+  // The line counter is global to the scanner.
+  yylineno = 1;
+  YY_BUFFER_STATE buffer = yy_scan_string(testCode.c_str());
+  yy_switch_to_buffer(buffer);
+  int result = yyparse();
+  yy_delete_buffer(buffer);
+
+  EXPECT_EQ(result, 0);
+
+  ProgramNode* program = static_cast<ProgramNode*>(root);
+  ASSERT_EQ(program->getItems().size(), 3);
+  EXPECT_EQ(program->getLine(0), 1);
+  EXPECT_EQ(program->getLine(1), 3);
+  EXPECT_EQ(program->getLine(2), 6);
+
+  ProcedureNode* procedure = static_cast<ProcedureNode*>(program->getItems()[1]);
+  EXPECT_EQ(procedure->line, 3);
+  EXPECT_EQ(static_cast<ProcedureBodyNode*>(procedure->body)->getLine(0), 4);
+}
+
+TEST(Parsing, shared_expression_items_keep_their_lines) {
+  std::string testCode = "a * b\nsave a * b in x\n\na * b\n";
+
+  yylineno = 1;
+  YY_BUFFER_STATE buffer = yy_scan_string(testCode.c_str());
+  yy_switch_to_buffer(buffer);
+  int result = yyparse();
+  yy_delete_buffer(buffer);
+
+  EXPECT_EQ(result, 0);
+
+  // Both expression lines are the same interned node, the lines are kept by the program.
+  ProgramNode* program = static_cast<ProgramNode*>(root);
+  std::vector<ASTNode*> items = program->getItems();
+  ASSERT_EQ(items.size(), 3);
+  EXPECT_EQ(items[0], items[2]);
+  EXPECT_EQ(items[0], static_cast<AssignmentNode*>(items[1])->value);
+  EXPECT_EQ(program->getLine(0), 1);
+  EXPECT_EQ(program->getLine(1), 2);
+  EXPECT_EQ(program->getLine(2), 4);
+}
+
+TEST(Parsing, subtraction_of_literals) {
+  std::string testCode = "save 10-3 in x\nsave -1.5-2 in y\n";
+
+  YY_BUFFER_STATE buffer = yy_scan_string(testCode.c_str());
+  yy_switch_to_buffer(buffer);
+  int result = yyparse();
+  yy_delete_buffer(buffer);
+
+  EXPECT_EQ(result, 0);
+
+  std::vector<ASTNode*> items = static_cast<ProgramNode*>(root)->getItems();
+  ASSERT_EQ(items.size(), 2);
+
+  // The '-' between digits subtracts instead of starting a word or a negative literal.
+  BinaryOpNode* x = static_cast<BinaryOpNode*>(static_cast<AssignmentNode*>(items[0])->value);
+  ASSERT_EQ(x->type, NodeType::BinaryOp);
+  EXPECT_EQ(x->op, '-');
+  EXPECT_EQ(static_cast<IntegerNode*>(x->left)->value, 10);
+  EXPECT_EQ(static_cast<IntegerNode*>(x->right)->value, 3);
+
+  BinaryOpNode* y = static_cast<BinaryOpNode*>(static_cast<AssignmentNode*>(items[1])->value);
+  ASSERT_EQ(y->type, NodeType::BinaryOp);
+  EXPECT_EQ(static_cast<NumberNode*>(y->left)->value, -1.5);
+  EXPECT_EQ(static_cast<IntegerNode*>(y->right)->value, 2);
+
+  delete root;
+  root = nullptr;
+}
+
+TEST(Parsing, equal_expressions_are_shared) {
+  std::string testCode = "save a * b + a * b in x\nsave (a * b) / 2 in y\nsave a * 2.0 in z\n";
+
+  YY_BUFFER_STATE buffer = yy_scan_string(testCode.c_str());
+  yy_switch_to_buffer(buffer);
+  int result = yyparse();
+  yy_delete_buffer(buffer);
+
+  EXPECT_EQ(result, 0);
+
+  std::vector<ASTNode*> items = static_cast<ProgramNode*>(root)->getItems();
+  ASSERT_EQ(items.size(), 3);
+
+  BinaryOpNode* sum = static_cast<BinaryOpNode*>(static_cast<AssignmentNode*>(items[0])->value);
+  BinaryOpNode* half = static_cast<BinaryOpNode*>(static_cast<AssignmentNode*>(items[1])->value);
+  BinaryOpNode* scaled = static_cast<BinaryOpNode*>(static_cast<AssignmentNode*>(items[2])->value);
+  EXPECT_EQ(sum->left, sum->right);
+  EXPECT_EQ(half->left, sum->left);
+  EXPECT_EQ(sum->left->references, 3u);
+  EXPECT_EQ(scaled->left, static_cast<BinaryOpNode*>(sum->left)->left);
+
+  delete root;
+  root = nullptr;
+}
@@ -0,0 +1,33 @@
+#include <gtest/gtest.h>
+#include <llvm/IR/GlobalVariable.h>
+
+#include "ast/ast.h"
+#include "compiler.h"
+#include "options.h"
+
+TEST(Compiler_profile, counters_are_emitted) {
+  ProgramNode program;
+  program.append(new ProcedureNode("my_procedure", new ProcedureBodyNode()));
+  program.append(new ProcedureCallNode("my_procedure"));
+  program.append(new NumberNode(1.0));
+
+  CompilerOptions options;
+  options.profileGenerate = "unused.prof";
+
+  Compiler c(&program, options);
+  c.generateCode();
+
+  // Every function increments its own counter.
+  EXPECT_NE(c.module->getGlobalVariable("hebe.prof.run"), nullptr);
+  EXPECT_NE(c.module->getGlobalVariable("hebe.prof.my_procedure"), nullptr);
+}
+
+TEST(Compiler_profile, no_counters_without_instrumentation) {
+  ProgramNode program;
+  program.append(new NumberNode(1.0));
+
+  Compiler c(&program);
+  c.generateCode();
+
+  EXPECT_EQ(c.module->getGlobalVariable("hebe.prof.run"), nullptr);
+}
@@ -0,0 +1,53 @@
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <llvm/IR/GlobalVariable.h>
+#include <string>
+
+#include "ast/ast.h"
+#include "compiler.h"
+#include "options.h"
+
+TEST(Compiler_state, globals_are_declared_with_state_file) {
+  ProgramNode program;
+  program.append(new AssignmentNode("x", new IntegerNode(1)));
+  program.append(new AssignmentNode("ret", new VariableNode("x")));
+
+  CompilerOptions options;
+  options.stateFile = "program.state";
+  Compiler c(&program, options);
+  c.generateCode();
+
+  // The JIT links them to the slots of the state file.
+  EXPECT_TRUE(c.module->getGlobalVariable("x")->isDeclaration());
+  EXPECT_TRUE(c.module->getGlobalVariable("ret")->isDeclaration());
+
+  Compiler plain(&program);
+  plain.generateCode();
+  EXPECT_FALSE(plain.module->getGlobalVariable("x")->isDeclaration());
+}
+
+TEST(Compiler_state, values_carry_over_between_runs) {
+  std::string path = "hebe_test_counter.state";
+  std::remove(path.c_str());
+
+  // save counter + 1 in counter
+  // save counter in ret
+  auto run = [&path] {
+    ProgramNode program;
+    program.append(new AssignmentNode(
+        "counter", new BinaryOpNode('+', new VariableNode("counter"), new IntegerNode(1))));
+    program.append(new AssignmentNode("ret", new VariableNode("counter")));
+
+    CompilerOptions options;
+    options.stateFile = path;
+    Compiler c(&program, options);
+    c.generateCode();
+    return c.runJIT();
+  };
+
+  // A missing file starts from zero, the second run starts from the checkpoint of the first.
+  EXPECT_EQ(run(), 1);
+  EXPECT_EQ(run(), 2);
+
+  std::remove(path.c_str());
+}
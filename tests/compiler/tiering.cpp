@@ -0,0 +1,35 @@
+#include <gtest/gtest.h>
+#include <llvm/IR/GlobalVariable.h>
+#include <llvm/IR/Instructions.h>
+
+#include "ast/ast.h"
+#include "compiler.h"
+#include "options.h"
+
+TEST(Compiler_tiered, calls_go_through_stubs) {
+  ProgramNode program;
+  program.append(new ProcedureNode("my_procedure", new ProcedureBodyNode()));
+  program.append(new ProcedureCallNode("my_procedure"));
+  program.append(new NumberNode(1.0));
+
+  CompilerOptions options;
+  options.tiered = true;
+
+  Compiler c(&program, options);
+  c.generateCode();
+
+  // The stub starts pointing to the procedure itself.
+  llvm::GlobalVariable* stub = c.module->getGlobalVariable("hebe.stub.my_procedure");
+  ASSERT_NE(stub, nullptr);
+  EXPECT_EQ(stub->getInitializer(), c.module->getFunction("my_procedure"));
+
+  // Hot procedures are detected with their entry counter.
+  EXPECT_NE(c.module->getGlobalVariable("hebe.prof.my_procedure"), nullptr);
+
+  // The call in run is indirect.
+  bool foundIndirectCall = false;
+  for (llvm::Instruction& inst : c.module->getFunction("run")->getEntryBlock())
+    if (auto* call = llvm::dyn_cast<llvm::CallInst>(&inst))
+      foundIndirectCall |= call->isIndirectCall();
+  EXPECT_TRUE(foundIndirectCall);
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+#include "ast/ast.h"
+
+// Helpers shared by the test suites.
+
+// Runs the function with stdout redirected to a pipe and returns what it wrote.
+template <typename F> std::string captureStdout(F function) {
+  int fds[2];
+  EXPECT_EQ(pipe(fds), 0);
+  int savedStdout = dup(STDOUT_FILENO);
+  dup2(fds[1], STDOUT_FILENO);
+  close(fds[1]);
+
+  // Read while the function writes so that it never blocks on a full pipe.
+  std::string output;
+  std::thread reader([&output, fd = fds[0]] {
+    char chunk[4096];
+    ssize_t size;
+    while ((size = read(fd, chunk, sizeof(chunk))) > 0)
+      output.append(chunk, static_cast<size_t>(size));
+  });
+
+  function();
+
+  dup2(savedStdout, STDOUT_FILENO);
+  close(savedStdout);
+  reader.join();
+  close(fds[0]);
+  return output;
+}
+
+// create <name>
+//     save <value> in <global>
+// done
+inline ProcedureNode* createWriter(const std::string& name, const std::string& global,
+                                   ASTNode* value) {
+  ProcedureBodyNode* body = new ProcedureBodyNode();
+  body->append(new AssignmentNode(global, value));
+  return new ProcedureNode(name, body);
+}
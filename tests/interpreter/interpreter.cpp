@@ -0,0 +1,210 @@
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+#include "ast/ast.h"
+#include "helpers.h"
+#include "interpreter/interpreter.h"
+
+TEST(Interpreter, integer_arithmetic) {
+  ProgramNode program;
+  program.append(new AssignmentNode(
+      "big", new BinaryOpNode('+', new IntegerNode(std::numeric_limits<int64_t>::max()),
+                              new IntegerNode(1))));
+  program.append(new AssignmentNode(
+      "quotient", new BinaryOpNode('/', new IntegerNode(-7), new IntegerNode(2))));
+  program.append(new AssignmentNode(
+      "product", new BinaryOpNode('*', new IntegerNode(6),
+                                  new BinaryOpNode('-', new IntegerNode(2), new IntegerNode(9)))));
+  program.append(new AssignmentNode("ret", new VariableNode("product")));
+
+  Interpreter interpreter(&program);
+  interpreter.compile();
+
+  EXPECT_EQ(interpreter.execute(), -42.0);
+  // Integers wrap around and divisions truncate, as in the generated code.
+  EXPECT_EQ(interpreter.getGlobal("big"),
+            static_cast<double>(std::numeric_limits<int64_t>::min()));
+  EXPECT_EQ(interpreter.getGlobal("quotient"), -3.0);
+}
+
+TEST(Interpreter, integer_division_is_defined) {
+  int64_t minimum = std::numeric_limits<int64_t>::min();
+  ProgramNode program;
+  program.append(
+      new AssignmentNode("zero", new BinaryOpNode('/', new IntegerNode(7), new IntegerNode(0))));
+  program.append(new AssignmentNode(
+      "wrapped", new BinaryOpNode('/', new IntegerNode(minimum), new IntegerNode(-1))));
+  program.append(new AssignmentNode(
+      "negated", new BinaryOpNode('/', new IntegerNode(5), new IntegerNode(-1))));
+  program.append(new AssignmentNode("ret", new IntegerNode(0)));
+
+  Interpreter interpreter(&program);
+  interpreter.compile();
+  interpreter.execute();
+
+  // x / 0 is 0 and the minimum value / -1 wraps around, as in the generated code.
+  EXPECT_EQ(interpreter.getGlobal("zero"), 0.0);
+  EXPECT_EQ(interpreter.getGlobal("wrapped"), static_cast<double>(minimum));
+  EXPECT_EQ(interpreter.getGlobal("negated"), -5.0);
+}
+
+TEST(Interpreter, conversions_follow_the_types) {
+  ProgramNode program;
+  // f32 operations are rounded to f32.
+  program.append(new AssignmentNode(
+      "f", new BinaryOpNode('/', new NumberNode(1.0, ValueType::F32), new IntegerNode(3))));
+  program.append(new AssignmentNode(
+      "d", new BinaryOpNode('+', new VariableNode("f"), new NumberNode(0.5))));
+  // The variable keeps the type of its first value.
+  program.append(new AssignmentNode("i", new IntegerNode(1)));
+  program.append(new AssignmentNode("i", new NumberNode(2.75)));
+  program.append(new AssignmentNode("ret", new VariableNode("d")));
+
+  Interpreter interpreter(&program);
+  interpreter.compile();
+
+  EXPECT_EQ(interpreter.execute(), static_cast<double>(1.0f / 3.0f) + 0.5);
+  EXPECT_EQ(interpreter.getGlobal("f"), static_cast<double>(1.0f / 3.0f));
+  EXPECT_EQ(interpreter.getGlobal("i"), 2.75);
+  EXPECT_EQ(interpreter.getGlobal("missing"), 0.0);
+}
+
+TEST(Interpreter, builtins) {
+  ProgramNode program;
+  program.append(new AssignmentNode("root", new BuiltinCallNode("sqrt", {new IntegerNode(16)})));
+  program.append(new AssignmentNode(
+      "smallest", new BuiltinCallNode("min", {new IntegerNode(3), new IntegerNode(-4)})));
+  program.append(
+      new AssignmentNode("magnitude", new BuiltinCallNode("abs", {new IntegerNode(-5)})));
+  program.append(new AssignmentNode(
+      "fused", new BuiltinCallNode("fma", {new NumberNode(2.0), new NumberNode(3.0),
+                                           new NumberNode(1.0)})));
+  program.append(new AssignmentNode("ret", new BuiltinCallNode("floor", {new IntegerNode(7)})));
+
+  Interpreter interpreter(&program);
+  interpreter.compile();
+
+  EXPECT_EQ(interpreter.execute(), 7.0);
+  EXPECT_EQ(interpreter.getGlobal("root"), 4.0);
+  EXPECT_EQ(interpreter.getGlobal("smallest"), -4.0);
+  EXPECT_EQ(interpreter.getGlobal("magnitude"), 5.0);
+  EXPECT_EQ(interpreter.getGlobal("fused"), 7.0);
+}
+
+TEST(Interpreter, procedures_share_globals) {
+  // create step
+  //     save x + 1 in x
+  // done
+  // step
+  // step
+  // save x in ret
+  ProcedureBodyNode* body = new ProcedureBodyNode();
+  body->append(
+      new AssignmentNode("x", new BinaryOpNode('+', new VariableNode("x"), new IntegerNode(1))));
+
+  ProgramNode program;
+  program.append(new ProcedureNode("step", body));
+  program.append(new ProcedureCallNode("step"));
+  program.append(new ProcedureCallNode("step"));
+  program.append(new AssignmentNode("ret", new VariableNode("x")));
+
+  Interpreter interpreter(&program);
+  interpreter.compile();
+
+  EXPECT_EQ(interpreter.execute(), 2.0);
+  EXPECT_EQ(interpreter.run(), 4);
+}
+
+TEST(Interpreter, invalid_programs) {
+  ProgramNode empty;
+  EXPECT_THROW(Interpreter(&empty).compile(), std::runtime_error);
+
+  ProgramNode undefinedCall;
+  undefinedCall.append(new ProcedureCallNode("missing"));
+  EXPECT_THROW(Interpreter(&undefinedCall).compile(), std::runtime_error);
+
+  ProgramNode duplicate;
+  duplicate.append(new ProcedureNode("p", new ProcedureBodyNode()));
+  duplicate.append(new ProcedureNode("p", new ProcedureBodyNode()));
+  EXPECT_THROW(Interpreter(&duplicate).compile(), std::runtime_error);
+}
+
+TEST(Interpreter, estimated_cost) {
+  ProcedureBodyNode* body = new ProcedureBodyNode();
+  body->append(new AssignmentNode("x", new IntegerNode(1)));
+
+  ProgramNode program;
+  program.append(new ProcedureNode("p", body));
+  program.append(new ProcedureCallNode("p"));
+  program.append(new ProcedureCallNode("p"));
+
+  Interpreter interpreter(&program);
+  interpreter.compile();
+
+  // run is two calls and a return, p a constant, a store and a return.
+  EXPECT_EQ(interpreter.getEstimatedCost(), 3u + 2 * 3u);
+
+  // Recursion can run any number of instructions.
+  ProcedureBodyNode* loopBody = new ProcedureBodyNode();
+  loopBody->append(new ProcedureCallNode("loop"));
+  ProgramNode recursive;
+  recursive.append(new ProcedureNode("loop", loopBody));
+  recursive.append(new ProcedureCallNode("loop"));
+
+  Interpreter recursiveInterpreter(&recursive);
+  recursiveInterpreter.compile();
+  EXPECT_EQ(recursiveInterpreter.getEstimatedCost(), std::numeric_limits<uint64_t>::max());
+}
+
+TEST(Interpreter, show_and_parallel_blocks) {
+  ProcedureBodyNode* aBody = new ProcedureBodyNode();
+  aBody->append(new AssignmentNode("x", new IntegerNode(1)));
+  ProcedureBodyNode* bBody = new ProcedureBodyNode();
+  bBody->append(new AssignmentNode("y", new NumberNode(2.5)));
+  ProcedureBodyNode* block = new ProcedureBodyNode();
+  block->append(new ProcedureCallNode("a"));
+  block->append(new ProcedureCallNode("b"));
+
+  ProgramNode program;
+  program.append(new ProcedureNode("a", aBody));
+  program.append(new ProcedureNode("b", bBody));
+  program.append(new ParallelNode(block));
+  program.append(new ShowNode({new VariableNode("x"), new VariableNode("y")}));
+  program.append(new AssignmentNode("ret", new VariableNode("x")));
+
+  Interpreter interpreter(&program);
+  interpreter.compile();
+
+  int exitCode = 0;
+  std::string output = captureStdout([&] { exitCode = interpreter.run(); });
+
+  EXPECT_EQ(exitCode, 1);
+  EXPECT_EQ(output, "1 2.5\n");
+}
+
+TEST(Interpreter, errors_in_parallel_blocks_are_rethrown) {
+  ProcedureBodyNode* loopBody = new ProcedureBodyNode();
+  loopBody->append(new ProcedureCallNode("loop"));
+  ProcedureBodyNode* otherBody = new ProcedureBodyNode();
+  otherBody->append(new AssignmentNode("x", new IntegerNode(1)));
+  ProcedureBodyNode* block = new ProcedureBodyNode();
+  block->append(new ProcedureCallNode("loop"));
+  block->append(new ProcedureCallNode("other"));
+
+  ProgramNode program;
+  program.append(new ProcedureNode("loop", loopBody));
+  program.append(new ProcedureNode("other", otherBody));
+  program.append(new ParallelNode(block));
+  program.append(new AssignmentNode("ret", new VariableNode("x")));
+
+  Interpreter interpreter(&program);
+  interpreter.compile();
+
+  // The call depth error of a task reaches the caller once the block ends instead of terminating
+  // the program from a pool thread.
+  EXPECT_THROW(interpreter.execute(), std::runtime_error);
+  EXPECT_EQ(interpreter.getGlobal("x"), 1.0);
+}
@@ -0,0 +1,136 @@
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ast/ast.h"
+#include "compiler.h"
+#include "helpers.h"
+#include "interpreter/interpreter.h"
+
+typedef struct yy_buffer_state* YY_BUFFER_STATE;
+extern YY_BUFFER_STATE yy_scan_string(const char* str);
+extern void yy_delete_buffer(YY_BUFFER_STATE buffer);
+extern void yy_switch_to_buffer(YY_BUFFER_STATE new_buffer);
+extern int yyparse();
+
+extern ASTNode* root;
+
+namespace {
+
+struct EquivalenceCase {
+  const char* name;
+  const char* code;
+};
+
+// Every program ends showing ret, so the output of the generated code has its full value and not
+// only the exit code. ret is an integer or a double in all of them so that the shown text reads
+// back the exact value.
+const std::vector<EquivalenceCase> cases = {
+    {"integers", "save 7 in a\n"
+                 "save -3 in b\n"
+                 "save a / b in q\n"
+                 "save a * b - 9223372036854775807 in w\n"
+                 "save a / 0 in z\n"
+                 "show a -> b -> q -> w -> z\n"
+                 "save q * 10 + a - b in ret\n"},
+    {"doubles", "save 1.5 in x\n"
+                "save x * x / 0.7 - 2.25 in y\n"
+                "show x -> y\n"
+                "save y / 3.0 in ret\n"},
+    {"floats", "save 1.5f in x\n"
+               "save x / 3.0f + 0.1f in y\n"
+               "show x -> y\n"
+               "save y * 7.0f + 0.0 in ret\n"},
+    {"conversions", "save 3 in i\n"
+                    "save 0.5f in f\n"
+                    "save 0.1 in d\n"
+                    "save i + f in fi\n"
+                    "save i * d in di\n"
+                    "save f + d in df\n"
+                    "save 1 in widened\n"
+                    "save 2.5 in widened\n"
+                    "show fi -> di -> df -> widened\n"
+                    "save fi + di + df + widened in ret\n"},
+    {"integer_builtins", "save -5 in n\n"
+                         "show abs(n) -> min(n, 3) -> max(n, 3) -> floor(n)\n"
+                         "save abs(n) * max(n, 2) - min(n, 0) + floor(n) in ret\n"},
+    {"double_builtins", "save 2.25 in x\n"
+                        "save -1.75 in y\n"
+                        "show sqrt(x) -> abs(y) -> min(x, y) -> max(x, y) -> fma(x, y, 0.5)\n"
+                        "show floor(y) -> exp(x) -> log(x) -> pow(x, y) -> sin(x) -> cos(y)\n"
+                        "save sqrt(x) + exp(y) * log(x) - pow(x, 0.5) + sin(y) * cos(x) in ret\n"},
+    {"float_builtins", "save 2.25f in x\n"
+                       "save -1.75f in y\n"
+                       "show sqrt(x) -> abs(y) -> min(x, y) -> max(x, y) -> fma(x, y, 0.5f)\n"
+                       "show floor(y) -> exp(x) -> log(x) -> pow(x, y) -> sin(x) -> cos(y)\n"
+                       "save sqrt(x) + exp(y) * log(x) - pow(x, 0.5f) + sin(y) + 0.0 in ret\n"},
+    {"integer_arguments_of_double_builtins", "save 2 in n\n"
+                                             "show sqrt(n) -> exp(n) -> log(n) -> pow(n, 10)\n"
+                                             "save sqrt(n) + pow(n, 3) in ret\n"},
+    {"procedures", "create grow\n"
+                   "    save x * 3 - 1 in x\n"
+                   "    save y + sqrt(x) / 2.0f in y\n"
+                   "done\n"
+                   "save 5 in x\n"
+                   "save 0.0f in y\n"
+                   "grow\n"
+                   "grow\n"
+                   "show x -> y\n"
+                   "save x / 4 + floor(y) + max(x, 2) in ret\n"},
+    {"parallel_blocks", "create a\n"
+                        "    save 1 in p\n"
+                        "done\n"
+                        "create b\n"
+                        "    save 2.5f in q\n"
+                        "done\n"
+                        "parallel\n"
+                        "    a\n"
+                        "    b\n"
+                        "done\n"
+                        "show p -> q\n"
+                        "save p + q + 0.0 in ret\n"},
+};
+
+std::unique_ptr<ASTNode> parse(const std::string& code) {
+  YY_BUFFER_STATE buffer = yy_scan_string(code.c_str());
+  yy_switch_to_buffer(buffer);
+  int result = yyparse();
+  yy_delete_buffer(buffer);
+  EXPECT_EQ(result, 0);
+
+  std::unique_ptr<ASTNode> program(root);
+  root = nullptr;
+  return program;
+}
+
+} // namespace
+
+TEST(Interpreter_jit_equivalence, same_values_and_output) {
+  for (const EquivalenceCase& testCase : cases) {
+    SCOPED_TRACE(testCase.name);
+    std::string code = std::string(testCase.code) + "show ret\n";
+
+    std::unique_ptr<ASTNode> interpreted = parse(code);
+    Interpreter interpreter(interpreted.get());
+    interpreter.compile();
+    int interpreterExitCode = 0;
+    std::string interpreterOutput =
+        captureStdout([&] { interpreterExitCode = interpreter.run(); });
+
+    std::unique_ptr<ASTNode> compiled = parse(code);
+    Compiler compiler(compiled.get());
+    compiler.generateCode();
+    int jitExitCode = 0;
+    std::string jitOutput = captureStdout([&] { jitExitCode = compiler.runJIT(); });
+
+    EXPECT_EQ(jitOutput, interpreterOutput);
+    EXPECT_EQ(jitExitCode, interpreterExitCode);
+
+    // The last line is ret shown by the generated code.
+    ASSERT_FALSE(jitOutput.empty());
+    size_t lineStart = jitOutput.rfind('\n', jitOutput.size() - 2);
+    std::string shownRet = jitOutput.substr(lineStart == std::string::npos ? 0 : lineStart + 1);
+    EXPECT_EQ(std::stod(shownRet), interpreter.getGlobal("ret"));
+  }
+}
@@ -0,0 +1,198 @@
+#include <climits>
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "lexer/identifier_table.h"
+#include "lexer/lexer.h"
+
+namespace {
+std::vector<Token> lexAll(const std::string& text) {
+  Lexer lexer(text);
+  std::vector<Token> tokens;
+  do {
+    tokens.push_back(lexer.next());
+  } while (tokens.back().kind != TokenKind::End);
+  return tokens;
+}
+
+std::vector<Token> lexFile(const std::string& text) {
+  FILE* file = std::tmpfile();
+  std::fwrite(text.data(), 1, text.size(), file);
+  std::rewind(file);
+
+  Lexer lexer(file);
+  std::vector<Token> tokens;
+  do {
+    tokens.push_back(lexer.next());
+  } while (tokens.back().kind != TokenKind::End);
+  std::fclose(file);
+  return tokens;
+}
+
+std::vector<TokenKind> kinds(const std::vector<Token>& tokens) {
+  std::vector<TokenKind> result;
+  for (const Token& token : tokens)
+    result.push_back(token.kind);
+  return result;
+}
+} // namespace
+
+TEST(Lexer, keywords_words_and_operators) {
+  std::vector<Token> tokens =
+      lexAll("save saved in x-1 -> ->x > create done\tshow parallel + - * /");
+
+  std::vector<TokenKind> expected = {
+      TokenKind::Save, TokenKind::Word, TokenKind::In, TokenKind::Word, TokenKind::Arrow,
+      TokenKind::Word, TokenKind::Word, TokenKind::Create, TokenKind::Done, TokenKind::Show,
+      TokenKind::Parallel, TokenKind::Char, TokenKind::Char, TokenKind::Char, TokenKind::Char,
+      TokenKind::End};
+  EXPECT_EQ(kinds(tokens), expected);
+
+  // Words longer than a keyword or containing '-' and '>' are single words, as in Flex.
+  EXPECT_STREQ(tokens[1].word, "saved");
+  EXPECT_STREQ(tokens[3].word, "x-1");
+  EXPECT_STREQ(tokens[5].word, "->x");
+  EXPECT_STREQ(tokens[6].word, ">");
+  EXPECT_EQ(tokens[11].character, '+');
+  EXPECT_EQ(tokens[12].character, '-');
+}
+
+TEST(Lexer, numbers) {
+  std::vector<Token> tokens = lexAll("42 -7 1.5 -0.25f 2.5Fx 1. 12ab -x");
+
+  std::vector<TokenKind> expected = {
+      TokenKind::Integer, TokenKind::Integer, TokenKind::Number, TokenKind::FNumber,
+      TokenKind::FNumber, TokenKind::Word, TokenKind::Integer, TokenKind::Char,
+      TokenKind::Integer, TokenKind::Word, TokenKind::Word, TokenKind::End};
+  EXPECT_EQ(kinds(tokens), expected);
+
+  EXPECT_EQ(tokens[0].integer, 42);
+  EXPECT_EQ(tokens[1].integer, -7);
+  EXPECT_EQ(tokens[2].number, 1.5);
+  EXPECT_EQ(tokens[3].number, -0.25);
+  EXPECT_EQ(tokens[4].number, 2.5);
+  EXPECT_STREQ(tokens[5].word, "x");
+  EXPECT_EQ(tokens[6].integer, 1);
+  EXPECT_EQ(tokens[7].character, '.');
+  // Words never start with a digit.
+  EXPECT_EQ(tokens[8].integer, 12);
+  EXPECT_STREQ(tokens[9].word, "ab");
+  EXPECT_STREQ(tokens[10].word, "-x");
+
+  // Conversions are exact.
+  EXPECT_EQ(lexAll("0.1")[0].number, 0.1);
+  EXPECT_EQ(lexAll("2.2250738585072014")[0].number, 2.2250738585072014);
+}
+
+TEST(Lexer, minus_between_digits_is_an_operator) {
+  std::vector<Token> tokens = lexAll("10-3 1.5-2.5f 7 -3 x-3");
+
+  std::vector<TokenKind> expected = {
+      TokenKind::Integer, TokenKind::Char,    TokenKind::Integer, TokenKind::Number,
+      TokenKind::Char,    TokenKind::FNumber, TokenKind::Integer, TokenKind::Integer,
+      TokenKind::Word,    TokenKind::End};
+  EXPECT_EQ(kinds(tokens), expected);
+
+  EXPECT_EQ(tokens[0].integer, 10);
+  EXPECT_EQ(tokens[1].character, '-');
+  EXPECT_EQ(tokens[2].integer, 3);
+  EXPECT_EQ(tokens[5].number, 2.5);
+  // Only a '-' right after a number, otherwise it is the sign or part of a word.
+  EXPECT_EQ(tokens[7].integer, -3);
+  EXPECT_STREQ(tokens[8].word, "x-3");
+}
+
+TEST(Lexer, integers_out_of_range_are_errors) {
+  std::vector<Token> tokens =
+      lexAll("99999999999999999999 -9223372036854775809 -9223372036854775808");
+
+  std::vector<TokenKind> expected = {TokenKind::Error, TokenKind::Error, TokenKind::Integer,
+                                     TokenKind::End};
+  EXPECT_EQ(kinds(tokens), expected);
+  EXPECT_EQ(tokens[2].integer, LLONG_MIN);
+}
+
+TEST(Lexer, lines_and_other_characters) {
+  std::vector<Token> tokens = lexAll("show sqrt(x, 2)\r\n\n    done");
+
+  std::vector<TokenKind> expected = {
+      TokenKind::Show, TokenKind::Word, TokenKind::Char, TokenKind::Word, TokenKind::Char,
+      TokenKind::Integer, TokenKind::Char, TokenKind::Newline, TokenKind::Newline, TokenKind::Done,
+      TokenKind::End};
+  EXPECT_EQ(kinds(tokens), expected);
+
+  EXPECT_EQ(tokens[2].character, '(');
+  EXPECT_EQ(tokens[4].character, ',');
+  EXPECT_EQ(tokens[0].line, 1);
+  EXPECT_EQ(tokens[9].line, 3);
+}
+
+TEST(Lexer, long_words_and_spaces) {
+  // Longer than one vector block.
+  std::string word(100, 'a');
+  word += "_Z9->";
+  std::vector<Token> tokens = lexAll(std::string(40, ' ') + word + std::string(33, '\t') + "in");
+
+  ASSERT_EQ(tokens.size(), 3u);
+  EXPECT_EQ(tokens[0].word, word);
+  EXPECT_EQ(tokens[1].kind, TokenKind::In);
+}
+
+TEST(Lexer, words_are_interned) {
+  std::vector<Token> tokens = lexAll("counter counter other");
+
+  EXPECT_EQ(tokens[0].word, tokens[1].word);
+  EXPECT_NE(tokens[0].word, tokens[2].word);
+  EXPECT_EQ(internIdentifier("counter"), tokens[0].word);
+  EXPECT_EQ(internIdentifier(std::string(100000, 'x')), internIdentifier(std::string(100000, 'x')));
+}
+
+TEST(Lexer, files_are_read_in_chunks) {
+  // Several chunks of short lines, a line longer than a chunk and a last line without a newline.
+  std::string text;
+  for (int i = 0; i < 20000; i++)
+    text += "save " + std::to_string(i) + " in x\n";
+  text += std::string(100000, 'a') + " 1.5\n\n  show x";
+
+  std::vector<Token> expected = lexAll(text);
+  std::vector<Token> tokens = lexFile(text);
+
+  ASSERT_EQ(kinds(tokens), kinds(expected));
+  for (size_t i = 0; i < tokens.size(); i++) {
+    EXPECT_EQ(tokens[i].line, expected[i].line);
+    if (tokens[i].kind == TokenKind::Integer) {
+      EXPECT_EQ(tokens[i].integer, expected[i].integer);
+    }
+    if (tokens[i].kind == TokenKind::Word) {
+      EXPECT_EQ(tokens[i].word, expected[i].word);
+    }
+  }
+  EXPECT_EQ(tokens[tokens.size() - 2].line, 20003);
+}
+
+TEST(Lexer, pipes_are_lexed_as_lines_arrive) {
+  int fds[2];
+  ASSERT_EQ(pipe(fds), 0);
+  FILE* input = fdopen(fds[0], "r");
+  Lexer lexer(input);
+
+  // The first line is lexed while the writer keeps the pipe open.
+  ASSERT_EQ(write(fds[1], "show x\nsave", 11), 11);
+  EXPECT_EQ(lexer.next().kind, TokenKind::Show);
+  EXPECT_EQ(lexer.next().kind, TokenKind::Word);
+  EXPECT_EQ(lexer.next().kind, TokenKind::Newline);
+
+  // The start of the second line waits for the rest of it.
+  ASSERT_EQ(write(fds[1], "d 1\n", 4), 4);
+  close(fds[1]);
+  Token word = lexer.next();
+  EXPECT_EQ(word.kind, TokenKind::Word);
+  EXPECT_STREQ(word.word, "saved");
+  EXPECT_EQ(lexer.next().kind, TokenKind::Integer);
+  EXPECT_EQ(lexer.next().kind, TokenKind::Newline);
+  EXPECT_EQ(lexer.next().kind, TokenKind::End);
+  std::fclose(input);
+}
@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+#include <vector>
+
+#include "lexer/identifier_table.h"
+#include "parser.hpp"
+
+// Interface of the scanner feeding the parser, Flex or the hand-written one depending on
+// HEBE_LEXER. Both must behave the same.
+typedef struct yy_buffer_state* YY_BUFFER_STATE;
+extern YY_BUFFER_STATE yy_scan_string(const char* str);
+extern void yy_delete_buffer(YY_BUFFER_STATE buffer);
+extern void yy_switch_to_buffer(YY_BUFFER_STATE new_buffer);
+
+extern int yylex();
+extern int yylineno;
+
+namespace {
+struct Scanned {
+  int token;
+  int line;
+};
+
+std::vector<Scanned> scanAll(const char* code) {
+  YY_BUFFER_STATE buffer = yy_scan_string(code);
+  yy_switch_to_buffer(buffer);
+
+  std::vector<Scanned> tokens;
+  int token;
+  while ((token = yylex()) != 0)
+    tokens.push_back({token, yylloc.first_line});
+
+  yy_delete_buffer(buffer);
+  return tokens;
+}
+} // namespace
+
+TEST(Yylex, tokens_and_values) {
+  yylineno = 1;
+  YY_BUFFER_STATE buffer = yy_scan_string("save -3 in x\nshow 1.5f, 2.5 -> y(");
+  yy_switch_to_buffer(buffer);
+
+  EXPECT_EQ(yylex(), SAVE);
+  EXPECT_EQ(yylex(), INTEGER);
+  EXPECT_EQ(yylval.ival, -3);
+  EXPECT_EQ(yylex(), IN);
+  EXPECT_EQ(yylex(), WORD);
+  EXPECT_EQ(yylval.sval, internIdentifier("x"));
+  EXPECT_EQ(yylex(), NEWLINE);
+  EXPECT_EQ(yylex(), SHOW);
+  EXPECT_EQ(yylex(), FNUMBER);
+  EXPECT_EQ(yylval.fval, 1.5);
+  EXPECT_EQ(yylex(), ',');
+  EXPECT_EQ(yylex(), NUMBER);
+  EXPECT_EQ(yylval.fval, 2.5);
+  EXPECT_EQ(yylex(), ARROW);
+  EXPECT_EQ(yylex(), WORD);
+  EXPECT_EQ(yylex(), '(');
+  EXPECT_EQ(yylex(), 0);
+
+  yy_delete_buffer(buffer);
+  yylineno = 1;
+}
+
+TEST(Yylex, minus_between_digits_and_integers_out_of_range) {
+  yylineno = 1;
+  std::vector<Scanned> tokens = scanAll("99999999999999999999 10-3");
+
+  ASSERT_EQ(tokens.size(), 4u);
+  // The parser stops at an invalid token without another message.
+  EXPECT_EQ(tokens[0].token, YYerror);
+  EXPECT_EQ(tokens[1].token, INTEGER);
+  EXPECT_EQ(tokens[2].token, '-');
+  EXPECT_EQ(tokens[3].token, INTEGER);
+  EXPECT_EQ(yylval.ival, 3);
+}
+
+TEST(Yylex, lines_are_tracked) {
+  yylineno = 1;
+  std::vector<Scanned> tokens = scanAll("save 1 in x\n\n  done\r\n");
+
+  ASSERT_EQ(tokens.size(), 8u);
+  EXPECT_EQ(tokens[0].line, 1);
+  EXPECT_EQ(tokens[3].line, 1);
+  // A newline is located in the line that follows it, as Flex counts it before the action.
+  EXPECT_EQ(tokens[4].token, NEWLINE);
+  EXPECT_EQ(tokens[4].line, 2);
+  EXPECT_EQ(tokens[6].token, DONE);
+  EXPECT_EQ(tokens[6].line, 3);
+  EXPECT_EQ(yylineno, 4);
+
+  // Lines keep counting across buffers until yylineno is reset.
+  tokens = scanAll("show x");
+  EXPECT_EQ(tokens[0].line, 4);
+  yylineno = 1;
+}
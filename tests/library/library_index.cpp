@@ -0,0 +1,60 @@
+#include <cstdio>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "library/library_index.h"
+
+TEST(LibraryIndex, write_and_read_index) {
+  std::string fileName = "hebe_test_library.index";
+
+  LibraryIndex written;
+  written.addGlobal("counter", ValueType::I64);
+  written.addGlobal("scale", ValueType::F32);
+  written.addProcedure({"increment", {"counter"}, {"counter"}});
+  written.addProcedure({"reset", {}, {"counter", "scale"}});
+  written.writeToFile(fileName);
+
+  LibraryIndex read = LibraryIndex::readFromFile(fileName);
+  std::remove(fileName.c_str());
+
+  EXPECT_EQ(read.getGlobals().size(), 2);
+  EXPECT_EQ(read.getGlobals().at("counter"), ValueType::I64);
+  EXPECT_EQ(read.getGlobals().at("scale"), ValueType::F32);
+
+  ASSERT_EQ(read.getProcedures().size(), 2);
+  const LibraryIndex::Procedure* reset = read.getProcedure("reset");
+  ASSERT_NE(reset, nullptr);
+  EXPECT_TRUE(reset->reads.empty());
+  EXPECT_EQ(reset->writes, (std::vector<std::string>{"counter", "scale"}));
+  EXPECT_EQ(read.getProcedure("increment")->reads, std::vector<std::string>{"counter"});
+  EXPECT_EQ(read.getProcedure("missing"), nullptr);
+}
+
+TEST(LibraryIndex, duplicated_procedure) {
+  LibraryIndex index;
+  index.addProcedure({"increment", {}, {}});
+  EXPECT_THROW(index.addProcedure({"increment", {}, {}}), std::runtime_error);
+}
+
+TEST(LibraryIndex, read_invalid_index) {
+  std::string fileName = "hebe_test_invalid_library.index";
+
+  {
+    std::ofstream file(fileName);
+    file << "# hebe library v1\nprocedure increment 3 counter\n";
+  }
+  EXPECT_THROW(LibraryIndex::readFromFile(fileName), std::runtime_error);
+
+  {
+    std::ofstream file(fileName);
+    file << "# hebe profile v1\nrun 1\n";
+  }
+  EXPECT_THROW(LibraryIndex::readFromFile(fileName), std::runtime_error);
+  std::remove(fileName.c_str());
+
+  EXPECT_THROW(LibraryIndex::readFromFile("hebe_file_that_does_not_exist.index"),
+               std::runtime_error);
+}
@@ -13,4 +13,9 @@ TEST(Logsys_logger, duplicated_initialization_of_logger) {
   logsys::init();
   std::shared_ptr<spdlog::logger> logger_2 = logsys::get();
   EXPECT_EQ(logger_1, logger_2);
-}
\ No newline at end of file
+}
+
+TEST(Logsys_logger, get_returns_the_same_logger_object) {
+  logsys::init();
+  EXPECT_EQ(&logsys::get(), &logsys::get());
+}
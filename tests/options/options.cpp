@@ -0,0 +1,204 @@
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "options.h"
+
+TEST(Options, parse_input_file_and_flags) {
+  char* argv[] = {(char*)"main", (char*)"-O2", (char*)"--profile-use=run.prof",
+                  (char*)"main.hebe"};
+  CompilerOptions options = parseOptions(4, argv);
+
+  EXPECT_EQ(options.inputFile, "main.hebe");
+  EXPECT_EQ(options.optLevel, 2);
+  EXPECT_EQ(options.profileUse, "run.prof");
+  EXPECT_TRUE(options.profileGenerate.empty());
+}
+
+TEST(Options, unknown_option) {
+  char* argv[] = {(char*)"main", (char*)"--not-an-option"};
+  EXPECT_THROW(parseOptions(2, argv), std::runtime_error);
+}
+
+TEST(Options, option_without_value) {
+  char* argv[] = {(char*)"main", (char*)"--profile-generate="};
+  EXPECT_THROW(parseOptions(2, argv), std::runtime_error);
+}
+
+TEST(Options, parse_tiered_options) {
+  char* argv[] = {(char*)"main", (char*)"--tiered", (char*)"--tier-up-threshold=50"};
+  CompilerOptions options = parseOptions(3, argv);
+
+  EXPECT_TRUE(options.tiered);
+  EXPECT_EQ(options.tierUpThreshold, 50);
+}
+
+TEST(Options, invalid_numeric_option) {
+  char* argv[] = {(char*)"main", (char*)"--tier-up-threshold=many"};
+  EXPECT_THROW(parseOptions(2, argv), std::runtime_error);
+}
+
+TEST(Options, parse_tracing_options) {
+  char* argv[] = {(char*)"main", (char*)"--trace=trace.json", (char*)"--async-log",
+                  (char*)"--log-level=debug"};
+  CompilerOptions options = parseOptions(4, argv);
+
+  EXPECT_EQ(options.traceFile, "trace.json");
+  EXPECT_TRUE(options.asyncLog);
+  EXPECT_EQ(options.logLevel, "debug");
+}
+
+TEST(Options, unknown_log_level) {
+  char* argv[] = {(char*)"main", (char*)"--log-level=loud"};
+  EXPECT_THROW(parseOptions(2, argv), std::runtime_error);
+}
+
+TEST(Options, parse_vector_library) {
+  char* argv[] = {(char*)"main", (char*)"-O3", (char*)"--veclib=SLEEF"};
+  CompilerOptions options = parseOptions(3, argv);
+
+  EXPECT_EQ(options.optLevel, 3);
+  EXPECT_EQ(options.vectorLibrary, "SLEEF");
+}
+
+TEST(Options, parse_thread_count) {
+  char* argv[] = {(char*)"main", (char*)"--threads=8"};
+  EXPECT_EQ(parseOptions(2, argv).threads, 8u);
+}
+
+TEST(Options, parse_low_memory) {
+  char* argv[] = {(char*)"main", (char*)"--low-memory"};
+  EXPECT_TRUE(parseOptions(2, argv).lowMemory);
+}
+
+TEST(Options, parse_profiler_registration) {
+  char* argv[] = {(char*)"main", (char*)"--perf"};
+  CompilerOptions options = parseOptions(2, argv);
+  EXPECT_TRUE(options.perf);
+  EXPECT_FALSE(options.gdb);
+  EXPECT_TRUE(options.debugInfo);
+
+  char* gdbArgv[] = {(char*)"main", (char*)"--gdb"};
+  options = parseOptions(2, gdbArgv);
+  EXPECT_TRUE(options.gdb);
+  EXPECT_TRUE(options.debugInfo);
+
+  char* debugArgv[] = {(char*)"main", (char*)"-g"};
+  options = parseOptions(2, debugArgv);
+  EXPECT_FALSE(options.perf);
+  EXPECT_TRUE(options.debugInfo);
+}
+
+TEST(Options, unknown_vector_library) {
+  char* argv[] = {(char*)"main", (char*)"--veclib=fastmath"};
+  EXPECT_THROW(parseOptions(2, argv), std::runtime_error);
+}
+
+TEST(Options, parse_fast_math_options) {
+  char* argv[] = {(char*)"main", (char*)"--fp-contract", (char*)"--fp-no-nans",
+                  (char*)"--fp-arcp"};
+  CompilerOptions options = parseOptions(4, argv);
+
+  EXPECT_FALSE(options.fastMath);
+  EXPECT_TRUE(options.fpContract);
+  EXPECT_FALSE(options.fpReassoc);
+  EXPECT_TRUE(options.fpNoNaNs);
+  EXPECT_FALSE(options.fpNoInfs);
+  EXPECT_TRUE(options.fpApproxRecip);
+
+  char* fastArgv[] = {(char*)"main", (char*)"--fast-math"};
+  EXPECT_TRUE(parseOptions(2, fastArgv).fastMath);
+}
+
+TEST(Options, parse_execution_mode) {
+  char* argv[] = {(char*)"main"};
+  EXPECT_EQ(parseOptions(1, argv).executionMode, ExecutionMode::Auto);
+
+  char* interpArgv[] = {(char*)"main", (char*)"--exec=interp", (char*)"--interp-threshold=500"};
+  CompilerOptions options = parseOptions(3, interpArgv);
+  EXPECT_EQ(options.executionMode, ExecutionMode::Interpreter);
+  EXPECT_EQ(options.interpreterThreshold, 500u);
+
+  char* jitArgv[] = {(char*)"main", (char*)"--exec=jit"};
+  EXPECT_EQ(parseOptions(2, jitArgv).executionMode, ExecutionMode::JIT);
+
+  char* unknownArgv[] = {(char*)"main", (char*)"--exec=aot"};
+  EXPECT_THROW(parseOptions(2, unknownArgv), std::runtime_error);
+}
+
+TEST(Options, interpreter_rejects_code_generation_options) {
+  char* argv[] = {(char*)"main", (char*)"--exec=interp", (char*)"--tiered"};
+  EXPECT_THROW(parseOptions(3, argv), std::runtime_error);
+
+  char* perfArgv[] = {(char*)"main", (char*)"--perf", (char*)"--exec=interp"};
+  EXPECT_THROW(parseOptions(3, perfArgv), std::runtime_error);
+
+  // There is no generated code to describe with debug information.
+  char* debugArgv[] = {(char*)"main", (char*)"-g", (char*)"--exec=interp"};
+  EXPECT_THROW(parseOptions(3, debugArgv), std::runtime_error);
+
+  // Nor code to optimize with a profile or IR to release.
+  char* profileArgv[] = {(char*)"main", (char*)"--profile-use=run.prof", (char*)"--exec=interp"};
+  EXPECT_THROW(parseOptions(3, profileArgv), std::runtime_error);
+
+  char* lowMemoryArgv[] = {(char*)"main", (char*)"--low-memory", (char*)"--exec=interp"};
+  EXPECT_THROW(parseOptions(3, lowMemoryArgv), std::runtime_error);
+}
+
+TEST(Options, parse_state_file) {
+  char* argv[] = {(char*)"main", (char*)"--state=run.state", (char*)"--state-readonly"};
+  CompilerOptions options = parseOptions(3, argv);
+  EXPECT_EQ(options.stateFile, "run.state");
+  EXPECT_TRUE(options.stateReadOnly);
+
+  char* readOnlyArgv[] = {(char*)"main", (char*)"--state-readonly"};
+  EXPECT_THROW(parseOptions(2, readOnlyArgv), std::runtime_error);
+
+  char* interpArgv[] = {(char*)"main", (char*)"--state=run.state", (char*)"--exec=interp"};
+  EXPECT_THROW(parseOptions(3, interpArgv), std::runtime_error);
+}
+
+TEST(Options, parse_libraries) {
+  char* argv[] = {(char*)"main", (char*)"--emit-library=math.bc", (char*)"a.hebe",
+                  (char*)"b.hebe"};
+  CompilerOptions options = parseOptions(4, argv);
+  EXPECT_EQ(options.libraryOutput, "math.bc");
+  EXPECT_EQ(options.inputFile, "a.hebe");
+  EXPECT_EQ(options.libraryInputFiles, std::vector<std::string>{"b.hebe"});
+
+  char* importArgv[] = {(char*)"main", (char*)"--library=math.bc", (char*)"--library=io.bc",
+                        (char*)"main.hebe"};
+  EXPECT_EQ(parseOptions(4, importArgv).libraries,
+            (std::vector<std::string>{"math.bc", "io.bc"}));
+
+  // Several files only make sense for a library, and a library is never run.
+  char* filesArgv[] = {(char*)"main", (char*)"a.hebe", (char*)"b.hebe"};
+  EXPECT_THROW(parseOptions(3, filesArgv), std::runtime_error);
+  char* stdinArgv[] = {(char*)"main", (char*)"--emit-library=math.bc"};
+  EXPECT_THROW(parseOptions(2, stdinArgv), std::runtime_error);
+  char* tieredArgv[] = {(char*)"main", (char*)"--emit-library=math.bc", (char*)"--tiered",
+                        (char*)"a.hebe"};
+  EXPECT_THROW(parseOptions(4, tieredArgv), std::runtime_error);
+  char* interpArgv[] = {(char*)"main", (char*)"--library=math.bc", (char*)"--exec=interp"};
+  EXPECT_THROW(parseOptions(3, interpArgv), std::runtime_error);
+}
+
+TEST(Options, profile_use_requires_optimizations) {
+  char* argv[] = {(char*)"main", (char*)"--profile-use=run.prof"};
+  EXPECT_EQ(parseOptions(2, argv).optLevel, 2);
+
+  char* o0Argv[] = {(char*)"main", (char*)"-O0", (char*)"--profile-use=run.prof"};
+  EXPECT_THROW(parseOptions(3, o0Argv), std::runtime_error);
+
+  char* tieredArgv[] = {(char*)"main", (char*)"--tiered", (char*)"--profile-use=run.prof"};
+  EXPECT_THROW(parseOptions(3, tieredArgv), std::runtime_error);
+}
+
+TEST(Options, low_memory_rejects_tiered) {
+  char* argv[] = {(char*)"main", (char*)"--low-memory"};
+  EXPECT_TRUE(parseOptions(2, argv).lowMemory);
+
+  char* tieredArgv[] = {(char*)"main", (char*)"--low-memory", (char*)"--tiered"};
+  EXPECT_THROW(parseOptions(3, tieredArgv), std::runtime_error);
+}
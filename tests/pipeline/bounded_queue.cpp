@@ -0,0 +1,31 @@
+#include <gtest/gtest.h>
+#include <optional>
+#include <thread>
+
+#include "pipeline/bounded_queue.h"
+
+TEST(BoundedQueue, keeps_order_between_threads) {
+  BoundedQueue<int> queue(4);
+  constexpr int count = 10000;
+
+  std::thread producer([&queue] {
+    for (int i = 0; i < count; i++)
+      queue.push(i);
+    queue.close();
+  });
+
+  int expected = 0;
+  while (std::optional<int> value = queue.pop())
+    EXPECT_EQ(*value, expected++);
+  producer.join();
+
+  EXPECT_EQ(expected, count);
+}
+
+TEST(BoundedQueue, push_fails_after_close) {
+  BoundedQueue<int> queue(1);
+  queue.close();
+
+  EXPECT_FALSE(queue.push(1));
+  EXPECT_FALSE(queue.pop().has_value());
+}
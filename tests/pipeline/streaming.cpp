@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+#include <llvm/IR/GlobalVariable.h>
+#include <string>
+
+#include "ast/ast.h"
+#include "compiler.h"
+#include "pipeline/streaming.h"
+
+typedef struct yy_buffer_state* YY_BUFFER_STATE;
+extern YY_BUFFER_STATE yy_scan_string(const char* str);
+extern void yy_delete_buffer(YY_BUFFER_STATE buffer);
+extern void yy_switch_to_buffer(YY_BUFFER_STATE new_buffer);
+
+extern ASTNode* root;
+extern int yylineno;
+
+namespace {
+const std::string testCode = "save 1 in x\n"
+                             "create p\n"
+                             "    save x + 1.5 in y\n"
+                             "done\n"
+                             "p\n"
+                             "save y in ret\n";
+} // namespace
+
+TEST(Streaming, inline_streaming_generates_code) {
+  YY_BUFFER_STATE buffer = yy_scan_string(testCode.c_str());
+  yy_switch_to_buffer(buffer);
+
+  Compiler c(nullptr);
+  int result = parseAndGenerateStreamed(c, false, 1);
+  yy_delete_buffer(buffer);
+
+  EXPECT_EQ(result, 0);
+
+  // Items were handed to the compiler instead of being kept in the AST.
+  EXPECT_TRUE(static_cast<ProgramNode*>(root)->getItems().empty());
+
+  EXPECT_TRUE(c.module->getGlobalVariable("x")->getValueType()->isIntegerTy(64));
+  EXPECT_TRUE(c.module->getGlobalVariable("y")->getValueType()->isDoubleTy());
+  EXPECT_NE(c.module->getFunction("p"), nullptr);
+  EXPECT_NE(c.module->getFunction("run")->getEntryBlock().getTerminator(), nullptr);
+}
+
+TEST(Streaming, threaded_streaming_generates_code) {
+  YY_BUFFER_STATE buffer = yy_scan_string(testCode.c_str());
+  yy_switch_to_buffer(buffer);
+
+  Compiler c(nullptr);
+  int result = parseAndGenerateStreamed(c, true, 1);
+  yy_delete_buffer(buffer);
+
+  EXPECT_EQ(result, 0);
+  EXPECT_TRUE(c.module->getGlobalVariable("y")->getValueType()->isDoubleTy());
+  EXPECT_NE(c.module->getFunction("run")->getEntryBlock().getTerminator(), nullptr);
+}
+
+TEST(Streaming, variable_read_before_assignment) {
+  YY_BUFFER_STATE buffer = yy_scan_string("save later in x\nsave 1 in later\n");
+  yy_switch_to_buffer(buffer);
+
+  // Streamed items can not see assignments that come after them.
+  Compiler c(nullptr);
+  EXPECT_THROW(parseAndGenerateStreamed(c, false, 1), std::runtime_error);
+  yy_delete_buffer(buffer);
+}
+
+TEST(Streaming, threaded_streaming_stops_parsing_on_error) {
+  std::string code = "save later in x\n";
+  for (int i = 0; i < 10000; i++)
+    code += "save 1 in y\n";
+
+  yylineno = 1;
+  YY_BUFFER_STATE buffer = yy_scan_string(code.c_str());
+  yy_switch_to_buffer(buffer);
+
+  Compiler c(nullptr);
+  EXPECT_THROW(parseAndGenerateStreamed(c, true, 1), std::runtime_error);
+  yy_delete_buffer(buffer);
+
+  // The parser stops a few items after the failed one instead of reading the whole input.
+  EXPECT_LT(yylineno, 100);
+  yylineno = 1;
+}
+
+TEST(Streaming, float_to_integer_conversions_saturate) {
+  // x and n keep the integer type of their first value, later values are converted to it.
+  YY_BUFFER_STATE buffer = yy_scan_string("save 1 in x\n"
+                                          "save 99999999999999999999.0 in x\n"
+                                          "save 0 in n\n"
+                                          "save sqrt(-1.0) in n\n"
+                                          "save x / 4611686018427387904 + n in ret\n");
+  yy_switch_to_buffer(buffer);
+
+  Compiler c(nullptr);
+  int result = parseAndGenerateStreamed(c, false, 1);
+  yy_delete_buffer(buffer);
+  ASSERT_EQ(result, 0);
+
+  // Out of range values clamp to the maximum, whose quotient by 2^62 is 1, and NaN is 0.
+  EXPECT_EQ(c.runJIT(), 1);
+}
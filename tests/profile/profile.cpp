@@ -0,0 +1,36 @@
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <string>
+
+#include "profile/profile.h"
+
+TEST(Profile, write_and_read_profile) {
+  std::string fileName = "hebe_test_profile.prof";
+
+  Profile written;
+  written.setCount("run", 1);
+  written.setCount("hot_procedure", 1000000);
+  written.setCount("cold_procedure", 0);
+  written.writeToFile(fileName);
+
+  Profile read = Profile::readFromFile(fileName);
+  std::remove(fileName.c_str());
+
+  EXPECT_EQ(read.size(), 3);
+  EXPECT_EQ(read.getCount("run"), 1);
+  EXPECT_EQ(read.getCount("hot_procedure"), 1000000);
+  EXPECT_TRUE(read.contains("cold_procedure"));
+  EXPECT_EQ(read.getCount("cold_procedure"), 0);
+  EXPECT_EQ(read.getMaxCount(), 1000000);
+}
+
+TEST(Profile, missing_procedure_has_no_count) {
+  Profile profile;
+  EXPECT_FALSE(profile.contains("missing"));
+  EXPECT_EQ(profile.getCount("missing"), 0);
+}
+
+TEST(Profile, read_missing_file) {
+  EXPECT_THROW(Profile::readFromFile("hebe_file_that_does_not_exist.prof"), std::runtime_error);
+}
@@ -0,0 +1,50 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+#include "helpers.h"
+#include "runtime/show.h"
+
+TEST(ShowRuntime, formats_values) {
+  std::string output = captureStdout([] {
+    hebe_show_i64(-42, ' ');
+    hebe_show_f32(1.5f, ' ');
+    hebe_show_f64(0.1, '\n');
+    hebe_show_flush();
+  });
+
+  // Floating point values use the shortest text that reads back the same value.
+  EXPECT_EQ(output, "-42 1.5 0.1\n");
+}
+
+TEST(ShowRuntime, output_is_buffered_until_flush) {
+  std::string output = captureStdout([] {
+    hebe_show_i64(1, '\n');
+
+    // The value is still in the buffer, so this is written first.
+    EXPECT_EQ(write(STDOUT_FILENO, "x", 1), 1);
+    hebe_show_flush();
+  });
+
+  EXPECT_EQ(output, "x1\n");
+}
+
+TEST(ShowRuntime, large_output_is_written_in_batches) {
+  constexpr int64_t count = 300000;
+
+  std::string output = captureStdout([] {
+    // The buffer of the thread is flushed when it exits.
+    std::thread writer([] {
+      for (int64_t i = 0; i < count; i++)
+        hebe_show_i64(i, '\n');
+    });
+    writer.join();
+  });
+
+  size_t lines = 0;
+  for (char c : output)
+    lines += c == '\n';
+  EXPECT_EQ(lines, static_cast<size_t>(count));
+  EXPECT_EQ(output.substr(0, 6), "0\n1\n2\n");
+}
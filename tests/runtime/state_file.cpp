@@ -0,0 +1,103 @@
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+
+#include "runtime/state_file.h"
+
+namespace {
+std::string statePath(const std::string& name) {
+  return "hebe_test_" + name + "_" + std::to_string(getpid()) + ".state";
+}
+} // namespace
+
+TEST(StateFile, values_survive_a_checkpoint) {
+  std::string path = statePath("checkpoint");
+  std::vector<StateFile::Variable> variables = {{"count", ValueType::I64},
+                                                {"scale", ValueType::F32},
+                                                {"ret", ValueType::F64}};
+
+  {
+    StateFile state(path, variables);
+    EXPECT_EQ(state.getGeneration(), 0u);
+    EXPECT_EQ(*static_cast<int64_t*>(state.getSlot("count")), 0);
+    EXPECT_EQ(state.getSlot("missing"), nullptr);
+
+    *static_cast<int64_t*>(state.getSlot("count")) = 41;
+    *static_cast<float*>(state.getSlot("scale")) = 0.5f;
+    state.checkpoint();
+    *static_cast<int64_t*>(state.getSlot("count")) = 42;
+  }
+
+  {
+    // Values written after the checkpoint are lost.
+    StateFile state(path, variables);
+    EXPECT_EQ(state.getGeneration(), 1u);
+    EXPECT_EQ(*static_cast<int64_t*>(state.getSlot("count")), 41);
+    EXPECT_EQ(*static_cast<float*>(state.getSlot("scale")), 0.5f);
+    EXPECT_EQ(*static_cast<double*>(state.getSlot("ret")), 0.0);
+
+    // Changes of a run that does not checkpoint stay in its private copy.
+    *static_cast<int64_t*>(state.getSlot("count")) = 7;
+  }
+
+  StateFile state(path, variables);
+  EXPECT_EQ(*static_cast<int64_t*>(state.getSlot("count")), 41);
+  std::remove(path.c_str());
+}
+
+TEST(StateFile, layout_changes_keep_other_values) {
+  std::string path = statePath("layout");
+
+  {
+    StateFile state(path, {{"a", ValueType::I64}, {"b", ValueType::F64}});
+    *static_cast<int64_t*>(state.getSlot("a")) = 3;
+    *static_cast<double*>(state.getSlot("b")) = 2.5;
+    state.checkpoint();
+  }
+
+  {
+    // Another program adds c and uses b as an integer.
+    StateFile state(path, {{"b", ValueType::I64}, {"c", ValueType::F32}});
+    EXPECT_EQ(*static_cast<int64_t*>(state.getSlot("a")), 3);
+    EXPECT_EQ(*static_cast<int64_t*>(state.getSlot("b")), 0);
+    EXPECT_EQ(*static_cast<float*>(state.getSlot("c")), 0.0f);
+    *static_cast<float*>(state.getSlot("c")) = 1.5f;
+    state.checkpoint();
+  }
+
+  StateFile state(path, {{"a", ValueType::I64}});
+  EXPECT_EQ(state.getGeneration(), 2u);
+  EXPECT_EQ(*static_cast<int64_t*>(state.getSlot("a")), 3);
+  EXPECT_EQ(*static_cast<float*>(state.getSlot("c")), 1.5f);
+  std::remove(path.c_str());
+}
+
+TEST(StateFile, invalid_files_are_rejected) {
+  std::string path = statePath("invalid");
+
+  std::ofstream(path) << "not a state file, but long enough to hold a header";
+  EXPECT_THROW(StateFile(path, {{"a", ValueType::I64}}), std::runtime_error);
+
+  std::ofstream(path) << "short";
+  EXPECT_THROW(StateFile(path, {{"a", ValueType::I64}}), std::runtime_error);
+
+  // A valid file whose index points outside of it.
+  std::remove(path.c_str());
+  {
+    StateFile state(path, {{"a", ValueType::I64}});
+    state.checkpoint();
+  }
+  {
+    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+    // nameOffset of the first entry, right after the 40 byte header.
+    uint64_t nameOffset = UINT64_MAX;
+    file.seekp(40);
+    file.write(reinterpret_cast<const char*>(&nameOffset), sizeof(nameOffset));
+  }
+  EXPECT_THROW(StateFile(path, {{"a", ValueType::I64}}), std::runtime_error);
+  std::remove(path.c_str());
+}
@@ -0,0 +1,55 @@
+#include <atomic>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <mutex>
+#include <set>
+#include <thread>
+
+#include "runtime/work_stealing_pool.h"
+
+TEST(WorkStealingPool, join_waits_for_all_tasks) {
+  WorkStealingPool pool(4);
+  WorkStealingPool::TaskGroup group;
+  std::atomic<int> done{0};
+
+  for (int i = 0; i < 1000; i++)
+    pool.spawn(group, [&done] { done++; });
+  pool.join(group);
+
+  EXPECT_EQ(done.load(), 1000);
+}
+
+TEST(WorkStealingPool, tasks_run_on_several_threads) {
+  WorkStealingPool pool(4);
+  WorkStealingPool::TaskGroup group;
+  std::mutex mutex;
+  std::set<std::thread::id> threads;
+
+  for (int i = 0; i < 64; i++)
+    pool.spawn(group, [&] {
+      std::this_thread::sleep_for(std::chrono::milliseconds(2));
+      std::lock_guard<std::mutex> lock(mutex);
+      threads.insert(std::this_thread::get_id());
+    });
+  pool.join(group);
+
+  EXPECT_GT(threads.size(), 1u);
+}
+
+TEST(WorkStealingPool, nested_groups_do_not_deadlock) {
+  // Every worker joins an inner group, which only finishes because joining threads run tasks.
+  WorkStealingPool pool(2);
+  WorkStealingPool::TaskGroup outer;
+  std::atomic<int> done{0};
+
+  for (int i = 0; i < 8; i++)
+    pool.spawn(outer, [&pool, &done] {
+      WorkStealingPool::TaskGroup inner;
+      for (int j = 0; j < 8; j++)
+        pool.spawn(inner, [&done] { done++; });
+      pool.join(inner);
+    });
+  pool.join(outer);
+
+  EXPECT_EQ(done.load(), 64);
+}
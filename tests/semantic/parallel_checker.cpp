@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <string>
+
+#include "ast/ast.h"
+#include "helpers.h"
+#include "semantic/parallel_checker.h"
+
+namespace {
+
+ParallelNode* createParallel(std::initializer_list<const char*> procedures) {
+  ProcedureBodyNode* body = new ProcedureBodyNode();
+  for (const char* name : procedures)
+    body->append(new ProcedureCallNode(name));
+  return new ParallelNode(body);
+}
+
+} // namespace
+
+TEST(ParallelChecker, independent_procedures) {
+  ProgramNode program;
+  program.append(new AssignmentNode("shared", new IntegerNode(1)));
+  program.append(createWriter("a", "x", new VariableNode("shared")));
+  program.append(createWriter("b", "y", new VariableNode("shared")));
+  program.append(createParallel({"a", "b"}));
+
+  // Both read shared, but each one writes its own global.
+  ParallelChecker checker;
+  EXPECT_NO_THROW(checker.check(&program));
+}
+
+TEST(ParallelChecker, conflicting_writes) {
+  ProgramNode program;
+  program.append(createWriter("a", "x", new IntegerNode(1)));
+  program.append(createWriter("b", "x", new IntegerNode(2)));
+  program.append(createParallel({"a", "b"}));
+
+  ParallelChecker checker;
+  EXPECT_THROW(checker.check(&program), std::runtime_error);
+}
+
+TEST(ParallelChecker, write_read_through_nested_call) {
+  // c calls a, which writes x, while b reads x.
+  ProcedureBodyNode* body = new ProcedureBodyNode();
+  body->append(new ProcedureCallNode("a"));
+
+  ProgramNode program;
+  program.append(createWriter("a", "x", new IntegerNode(1)));
+  program.append(createWriter("b", "y", new VariableNode("x")));
+  program.append(new ProcedureNode("c", body));
+  program.append(createParallel({"c", "b"}));
+
+  ParallelChecker checker;
+  EXPECT_THROW(checker.check(&program), std::runtime_error);
+}
+
+TEST(ParallelChecker, same_writer_twice) {
+  ProgramNode program;
+  program.append(createWriter("a", "x", new IntegerNode(1)));
+  program.append(createParallel({"a", "a"}));
+
+  ParallelChecker checker;
+  EXPECT_THROW(checker.check(&program), std::runtime_error);
+}
+
+TEST(ParallelChecker, only_procedure_calls) {
+  ProcedureBodyNode* body = new ProcedureBodyNode();
+  body->append(new AssignmentNode("x", new IntegerNode(1)));
+
+  ProgramNode program;
+  program.append(new ParallelNode(body));
+
+  ParallelChecker checker;
+  EXPECT_THROW(checker.check(&program), std::runtime_error);
+}
+
+TEST(ParallelChecker, declared_procedures) {
+  ProgramNode program;
+  program.append(createWriter("local", "x", new IntegerNode(1)));
+  program.append(createParallel({"imported", "local"}));
+
+  // A procedure of a library writing the same global as a procedure of the program.
+  ParallelChecker checker;
+  checker.declareProcedure("imported", {{}, {"x"}});
+  EXPECT_THROW(checker.check(&program), std::runtime_error);
+
+  ParallelChecker independent;
+  independent.declareProcedure("imported", {{"y"}, {"z"}});
+  EXPECT_NO_THROW(independent.check(&program));
+}
@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+#include <stdexcept>
+
+#include "ast/ast.h"
+#include "semantic/type_checker.h"
+
+TEST(TypeChecker, literal_types) {
+  ProgramNode program;
+  program.append(new AssignmentNode("i", new IntegerNode(1)));
+  program.append(new AssignmentNode("f", new NumberNode(1.0, ValueType::F32)));
+  program.append(new AssignmentNode("d", new NumberNode(1.0)));
+
+  TypeChecker checker;
+  checker.check(&program);
+
+  EXPECT_EQ(checker.getVariableType("i"), ValueType::I64);
+  EXPECT_EQ(checker.getVariableType("f"), ValueType::F32);
+  EXPECT_EQ(checker.getVariableType("d"), ValueType::F64);
+}
+
+TEST(TypeChecker, binary_op_takes_widest_type) {
+  BinaryOpNode* intOp = new BinaryOpNode('*', new IntegerNode(2), new IntegerNode(3));
+  BinaryOpNode* mixedOp =
+      new BinaryOpNode('+', new IntegerNode(2), new NumberNode(1.0, ValueType::F32));
+
+  ProgramNode program;
+  program.append(intOp);
+  program.append(mixedOp);
+
+  TypeChecker checker;
+  checker.check(&program);
+
+  EXPECT_EQ(intOp->valueType, ValueType::I64);
+  EXPECT_EQ(mixedOp->valueType, ValueType::F32);
+}
+
+TEST(TypeChecker, variable_read_before_assignment_in_procedure) {
+  // create p
+  //     save x + 1 in y
+  // done
+  // save 2.0 in x
+  ProcedureBodyNode* body = new ProcedureBodyNode();
+  VariableNode* read = new VariableNode("x");
+  body->append(new AssignmentNode("y", new BinaryOpNode('+', read, new IntegerNode(1))));
+
+  ProgramNode program;
+  program.append(new ProcedureNode("p", body));
+  program.append(new AssignmentNode("x", new NumberNode(2.0)));
+
+  TypeChecker checker;
+  checker.check(&program);
+
+  EXPECT_EQ(read->valueType, ValueType::F64);
+  EXPECT_EQ(checker.getVariableType("y"), ValueType::F64);
+}
+
+TEST(TypeChecker, variable_never_assigned) {
+  ProgramNode program;
+  program.append(new AssignmentNode("y", new VariableNode("missing")));
+
+  TypeChecker checker;
+  EXPECT_THROW(checker.check(&program), std::runtime_error);
+}
+
+TEST(TypeChecker, builtin_call_types) {
+  BuiltinCallNode* absCall = new BuiltinCallNode("abs", {new IntegerNode(-2)});
+  BuiltinCallNode* sqrtCall = new BuiltinCallNode("sqrt", {new IntegerNode(2)});
+  BuiltinCallNode* powCall =
+      new BuiltinCallNode("pow", {new NumberNode(2.0, ValueType::F32), new IntegerNode(3)});
+
+  ProgramNode program;
+  program.append(absCall);
+  program.append(sqrtCall);
+  program.append(powCall);
+
+  TypeChecker checker;
+  checker.check(&program);
+
+  EXPECT_EQ(absCall->valueType, ValueType::I64);
+  EXPECT_EQ(sqrtCall->valueType, ValueType::F64);
+  EXPECT_EQ(powCall->valueType, ValueType::F32);
+}
+
+TEST(TypeChecker, invalid_builtin_calls) {
+  ProgramNode unknown;
+  unknown.append(new BuiltinCallNode("tan", {new NumberNode(1.0)}));
+  EXPECT_THROW(TypeChecker().check(&unknown), std::runtime_error);
+
+  ProgramNode wrongArity;
+  wrongArity.append(new BuiltinCallNode("min", {new NumberNode(1.0)}));
+  EXPECT_THROW(TypeChecker().check(&wrongArity), std::runtime_error);
+}
+
+TEST(TypeChecker, declared_variable_keeps_its_type) {
+  ProgramNode program;
+  program.append(new AssignmentNode("counter", new NumberNode(1.5)));
+  program.append(new AssignmentNode("copy", new VariableNode("counter")));
+
+  // Assigning a f64 does not widen a variable declared as i64.
+  TypeChecker checker;
+  checker.declareVariable("counter", ValueType::I64);
+  checker.check(&program);
+
+  EXPECT_EQ(checker.getVariableType("counter"), ValueType::I64);
+  EXPECT_EQ(checker.getVariableType("copy"), ValueType::I64);
+}
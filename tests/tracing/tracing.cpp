@@ -0,0 +1,43 @@
+#include <cstdio>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+
+#include "tracing.h"
+
+TEST(Tracing, disabled_scopes_record_nothing) {
+  tracing::clear();
+  { HEBE_TRACE_SCOPE("disabled"); }
+
+  // Tracing is disabled until enable() is called.
+  EXPECT_FALSE(tracing::isEnabled());
+  EXPECT_EQ(tracing::getEventCount(), 0);
+}
+
+TEST(Tracing, write_chrome_trace) {
+  std::string fileName = "hebe_test_trace.json";
+
+  tracing::enable();
+  tracing::clear();
+  {
+    HEBE_TRACE_SCOPE("outerPhase");
+    HEBE_TRACE_SCOPE("innerPhase");
+  }
+  EXPECT_EQ(tracing::getEventCount(), 2);
+
+  // The other tests run with tracing disabled.
+  tracing::disable();
+  tracing::writeChromeTrace(fileName);
+  tracing::clear();
+
+  std::ifstream file(fileName);
+  std::stringstream content;
+  content << file.rdbuf();
+  std::remove(fileName.c_str());
+
+  EXPECT_NE(content.str().find("\"traceEvents\""), std::string::npos);
+  EXPECT_NE(content.str().find("\"name\":\"outerPhase\""), std::string::npos);
+  EXPECT_NE(content.str().find("\"name\":\"innerPhase\""), std::string::npos);
+  EXPECT_NE(content.str().find("\"ph\":\"X\""), std::string::npos);
+}